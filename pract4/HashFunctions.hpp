@@ -3,8 +3,59 @@
 
 #include <iostream>
 #include <cstdlib>
-#include <ctime>
 #include <string>
+#include <deque>
+#include <unordered_map>
+#include <mutex>
+
+// Mezclador de 64 bits (finalizador de splitmix64): cada bit de la entrada
+// afecta a todos los de la salida, por lo que claves consecutivas dan valores
+// muy distintos.
+inline unsigned long long mix64(unsigned long long x) {
+    x ^= x >> 30;
+    x *= 0xbf58476d1ce4e5b9ULL;
+    x ^= x >> 27;
+    x *= 0x94d049bb133111ebULL;
+    x ^= x >> 31;
+    return x;
+}
+
+// Generador pseudoaleatorio splitmix64. Todo su estado es local al objeto, así que
+// no toca el estado global de rand() y puede usarse desde varios hilos a la vez.
+// Con la misma semilla produce siempre la misma secuencia, y como el estado solo
+// avanza sumando gamma, el n-ésimo valor se puede calcular directamente (at).
+class SplitMix64 {
+private:
+    unsigned long long state;
+public:
+    static const unsigned long long gamma = 0x9e3779b97f4a7c15ULL;
+    explicit SplitMix64(unsigned long long seed) : state(seed) {}
+    unsigned long long next() {
+        state += gamma;
+        return mix64(state);
+    }
+    // n-ésimo valor (n >= 1) de la secuencia con semilla seed, en tiempo constante.
+    static unsigned long long at(unsigned long long seed, unsigned long long n) {
+        return mix64(seed + n * gamma);
+    }
+};
+
+// ----------------------------
+// Clave numérica
+// ----------------------------
+// Valor numérico de una clave y su hash de 64 bits, sin el resto de datos.
+// Todas las funciones de dispersión y exploración solo usan esos dos valores,
+// así que sirve para buscar en una tabla sin construir la clave completa
+// (HashTable::find). Coincide con cualquier clave de su mismo valor numérico.
+class NumericKey {
+private:
+    long value;
+    unsigned long long valueHash; // mix64(value)
+public:
+    explicit NumericKey(long value) : value(value), valueHash(mix64(value)) {}
+    operator long() const { return value; }
+    unsigned long long hashValue() const { return valueHash; }
+};
 
 // ----------------------------
 // Clase persona
@@ -13,46 +64,75 @@
 // El ID tiene el formato: <tipo><7 dígitos>, donde <tipo> es "alu", "prof" o "pas".
 // La conversión a long se realiza extrayendo la parte numérica y sumando un offset
 // según el tipo, de modo que "prof" y "pas" se diferencian de "alu".
+// El valor numérico y su hash se calculan una sola vez al construir la persona,
+// de modo que las funciones de dispersión y exploración solo leen un campo.
 class persona {
 private:
     std::string id;       // Ejemplos: "alu0001345", "prof0001234", "pas0001234"
     std::string nombre;
     std::string apellido1;
     std::string apellido2;
+    long key;                   // Valor numérico del ID (ver parseId)
+    unsigned long long keyHash; // mix64(key)
 public:
     // Constructor que recibe todos los datos
     persona(const std::string &id, const std::string &nombre,
             const std::string &apellido1, const std::string &apellido2)
-      : id(id), nombre(nombre), apellido1(apellido1), apellido2(apellido2) {}
+      : id(id), nombre(nombre), apellido1(apellido1), apellido2(apellido2),
+        key(parseId(id)), keyHash(mix64(key)) {}
 
     // Constructor por defecto (vacío, aunque podría generar datos aleatorios)
-    persona() : id("alu0000000"), nombre(""), apellido1(""), apellido2("") {}
+    persona() : id("alu0000000"), nombre(""), apellido1(""), apellido2(""),
+                key(0), keyHash(mix64(0)) {}
 
-    // Operador de conversión a long:
-    // Extrae la parte numérica (7 dígitos) y le suma un offset según el prefijo.
+    // Calcula el valor numérico de un ID:
+    // extrae la parte numérica (7 dígitos) y le suma un offset según el prefijo.
     // Offset: "alu" -> 0, "prof" -> 10000000, "pas" -> 20000000.
-    operator long() const {
+    // Un ID mal formado (prefijo desconocido, un número de dígitos distinto de 7 o
+    // otros caracteres detrás) da -1: con más dígitos invadiría el rango de otro
+    // prefijo y con menos, "alu1" daría el mismo valor que "alu0000001".
+    static long parseId(const std::string &id) {
         long offset = 0;
-        std::string numPart;
-        if(id.substr(0,4) == "prof") {
+        size_t start = 0;
+        if(id.compare(0, 4, "prof") == 0) {
             offset = 10000000;
-            numPart = id.substr(4); // Desde el 5º carácter
-        } else if(id.substr(0,3) == "pas") {
+            start = 4; // Desde el 5º carácter
+        } else if(id.compare(0, 3, "pas") == 0) {
             offset = 20000000;
-            numPart = id.substr(3);
-        } else if(id.substr(0,3) == "alu") {
-            offset = 0;
-            numPart = id.substr(3);
+            start = 3;
+        } else if(id.compare(0, 3, "alu") == 0) {
+            start = 3;
         } else {
-            // Si el formato es desconocido, se usa 0
-            numPart = "0";
+            return -1;
+        }
+        if(id.size() - start != 7)
+            return -1;
+        long num = 0;
+        for(size_t i = start; i < id.size(); i++) {
+            if(id[i] < '0' || id[i] > '9')
+                return -1;
+            num = num * 10 + (id[i] - '0');
         }
-        return offset + std::stol(numPart);
+        return offset + num;
     }
+    // Indica si un ID está bien formado (parseId no da -1).
+    static bool validId(const std::string &id) { return parseId(id) >= 0; }
+    // Clave de búsqueda de un ID, para HashTable::find.
+    static NumericKey idKey(const std::string &id) { return NumericKey(parseId(id)); }
+
+    // Operador de conversión a long: devuelve el valor calculado en el constructor.
+    operator long() const { return key; }
+
+    // Indica si el ID de la persona está bien formado (ver parseId).
+    bool valid() const { return key >= 0; }
+
+    // Hash de 64 bits del ID, también precalculado.
+    unsigned long long hashValue() const { return keyHash; }
 
     // Operadores de comparación: se comparan los ID (se asume que son únicos).
-    bool operator==(const persona &other) const { return id == other.id; }
-    bool operator!=(const persona &other) const { return id != other.id; }
+    // La igualdad descarta primero por el valor numérico, que es una sola comparación.
+    bool operator==(const persona &other) const { return key == other.key && id == other.id; }
+    bool operator!=(const persona &other) const { return !(*this == other); }
     bool operator<(const persona &other) const { return id < other.id; }
     bool operator>(const persona &other) const { return id > other.id; }
 
@@ -63,123 +143,516 @@ public:
     std::string getApellido2() const { return apellido2; }
 };
 
+// Hash de 64 bits de una clave: para persona es el valor precalculado y
+// para cualquier otra clave se mezcla su valor numérico.
+template<class Key>
+unsigned long long fullHash(const Key &key) {
+    return mix64(static_cast<unsigned long long>(static_cast<long>(key)));
+}
+inline unsigned long long fullHash(const persona &p) { return p.hashValue(); }
+inline unsigned long long fullHash(const NumericKey &k) { return k.hashValue(); }
+
+// ----------------------------
+// Clase personaCompacta
+// ----------------------------
+
+// Almacén de cadenas internadas: cada cadena distinta se guarda una sola vez y
+// se identifica por un índice de 32 bits. Se usa para los nombres y apellidos
+// de personaCompacta, que se repiten mucho entre registros.
+class StringPool {
+private:
+    std::unordered_map<std::string, unsigned> index;
+    std::deque<std::string> strings; // deque: las referencias no se invalidan al crecer
+    mutable std::mutex mtx;
+    StringPool() { intern(""); } // El índice 0 es la cadena vacía
+public:
+    static StringPool& instance() {
+        static StringPool pool;
+        return pool;
+    }
+    // Devuelve el índice de la cadena, añadiéndola si no estaba.
+    unsigned intern(const std::string &str) {
+        std::lock_guard<std::mutex> lock(mtx);
+        std::unordered_map<std::string, unsigned>::const_iterator it = index.find(str);
+        if(it != index.end()) return it->second;
+        unsigned idx = static_cast<unsigned>(strings.size());
+        strings.push_back(str);
+        index.insert(std::make_pair(str, idx));
+        return idx;
+    }
+    const std::string& get(unsigned idx) const {
+        std::lock_guard<std::mutex> lock(mtx);
+        return strings[idx];
+    }
+};
+
+// Versión compacta de persona (16 bytes, sin memoria dinámica propia).
+// El ID se empaqueta en un entero: 2 bits de tipo (0 alu, 1 prof, 2 pas) en los
+// bits 24-25 y el número de 7 dígitos en los bits 0-23. Nombre y apellidos son
+// índices en el StringPool. Copiar una personaCompacta no reserva memoria y la
+// igualdad es una única comparación de enteros.
+// La conversión a long da el mismo valor que persona, así que ambas se dispersan igual.
+// Un ID mal formado (parseId da -1) no se empaqueta: se guarda como invalidCode,
+// que no coincide con ningún ID válido, y la conversión a long vuelve a dar -1.
+class personaCompacta {
+private:
+    unsigned code;      // Tipo y número del ID empaquetados
+    unsigned nombre;    // Índices en StringPool
+    unsigned apellido1;
+    unsigned apellido2;
+
+    enum { invalidCode = 0xFFFFFFFFu };
+
+    static unsigned pack(long key) {
+        if(key < 0)
+            return invalidCode;
+        unsigned tipo = static_cast<unsigned>(key / 10000000);
+        unsigned num = static_cast<unsigned>(key % 10000000);
+        return (tipo << 24) | num;
+    }
+public:
+    personaCompacta(const std::string &id, const std::string &nombre,
+                    const std::string &apellido1, const std::string &apellido2)
+      : code(pack(persona::parseId(id))),
+        nombre(StringPool::instance().intern(nombre)),
+        apellido1(StringPool::instance().intern(apellido1)),
+        apellido2(StringPool::instance().intern(apellido2)) {}
+
+    explicit personaCompacta(const persona &p)
+      : code(pack(static_cast<long>(p))),
+        nombre(StringPool::instance().intern(p.getNombre())),
+        apellido1(StringPool::instance().intern(p.getApellido1())),
+        apellido2(StringPool::instance().intern(p.getApellido2())) {}
+
+    personaCompacta() : code(0), nombre(0), apellido1(0), apellido2(0) {}
+
+    operator long() const {
+        if(code == invalidCode)
+            return -1;
+        return static_cast<long>(code >> 24) * 10000000 + (code & 0xFFFFFF);
+    }
+
+    bool valid() const { return code != invalidCode; }
+
+    bool operator==(const personaCompacta &other) const { return code == other.code; }
+    bool operator!=(const personaCompacta &other) const { return code != other.code; }
+    bool operator<(const personaCompacta &other) const { return code < other.code; }
+    bool operator>(const personaCompacta &other) const { return code > other.code; }
+
+    // Reconstruye el ID en texto (p. ej. "prof0001234"); vacío si no es válido.
+    std::string getId() const {
+        if(code == invalidCode)
+            return std::string();
+        static const char *prefixes[] = {"alu", "prof", "pas", "alu"};
+        std::string num = std::to_string(code & 0xFFFFFF);
+        return prefixes[code >> 24] + std::string(7 - num.size(), '0') + num;
+    }
+    const std::string& getNombre() const { return StringPool::instance().get(nombre); }
+    const std::string& getApellido1() const { return StringPool::instance().get(apellido1); }
+    const std::string& getApellido2() const { return StringPool::instance().get(apellido2); }
+};
+
 // ----------------------------
 // Funciones de Dispersión
 // ----------------------------
 
 // Clase base abstracta para las funciones de dispersión.
 // Dado un objeto de tipo Key (ahora persona), retorna una posición en la tabla.
+// hash(key, ts) calcula la posición para una tabla de ts celdas, de modo que una
+// tabla que cambia de tamaño puede seguir usando la misma función; operator()
+// usa el tamaño actual, que se cambia con setTableSize.
+// Las funciones concretas son final: usadas por su tipo exacto (p. ej. como
+// parámetro Fd de HashTable) sus llamadas no son virtuales.
+// hash también acepta una NumericKey, que debe dar la misma posición que
+// cualquier clave con su valor numérico.
 template<class Key>
 class DispersionFunction {
+protected:
+    unsigned tableSize;
 public:
-    virtual unsigned operator()(const Key &key) const = 0;
+    explicit DispersionFunction(unsigned ts) : tableSize(ts) {}
+    virtual unsigned hash(const Key &key, unsigned ts) const = 0;
+    virtual unsigned hash(const NumericKey &key, unsigned ts) const = 0;
+    unsigned operator()(const Key &key) const { return hash(key, tableSize); }
+    unsigned getTableSize() const { return tableSize; }
+    void setTableSize(unsigned ts) { tableSize = ts; }
     virtual ~DispersionFunction() {}
 };
 
 // Función de dispersión usando el método módulo.
 // Calcula: h(k) = (valor numérico de key) % tableSize.
 template<class Key>
-class ModuleHashFunction : public DispersionFunction<Key> {
+class ModuleHashFunction final : public DispersionFunction<Key> {
 private:
-    unsigned tableSize;
-public:
-    ModuleHashFunction(unsigned ts) : tableSize(ts) {}
-    unsigned operator()(const Key &key) const {
-        return static_cast<unsigned>(static_cast<long>(key)) % tableSize;
+    template<class K>
+    static unsigned position(const K &key, unsigned ts) {
+        return static_cast<unsigned>(static_cast<long>(key)) % ts;
     }
+public:
+    ModuleHashFunction(unsigned ts) : DispersionFunction<Key>(ts) {}
+    unsigned hash(const Key &key, unsigned ts) const override { return position(key, ts); }
+    unsigned hash(const NumericKey &key, unsigned ts) const override { return position(key, ts); }
 };
 
 // Función de dispersión basada en la suma de dígitos de la parte numérica de key.
 // Calcula: h(k) = (suma de dígitos del valor numérico) % tableSize.
 template<class Key>
-class SumHashFunction : public DispersionFunction<Key> {
+class SumHashFunction final : public DispersionFunction<Key> {
 private:
-    unsigned tableSize;
-public:
-    SumHashFunction(unsigned ts) : tableSize(ts) {}
-    unsigned operator()(const Key &key) const {
+    template<class K>
+    static unsigned position(const K &key, unsigned ts) {
         long n = static_cast<long>(key);
         unsigned sum = 0;
         while(n > 0) {
             sum += n % 10;
             n /= 10;
         }
-        return sum % tableSize;
+        return sum % ts;
     }
+public:
+    SumHashFunction(unsigned ts) : DispersionFunction<Key>(ts) {}
+    unsigned hash(const Key &key, unsigned ts) const override { return position(key, ts); }
+    unsigned hash(const NumericKey &key, unsigned ts) const override { return position(key, ts); }
 };
 
 // Función de dispersión pseudoaleatoria.
-// Inicializa la semilla con el valor numérico de key y retorna un número aleatorio en [0, tableSize-1].
+// Retorna un número pseudoaleatorio en [0, tableSize-1] determinado por la clave:
+// la mezcla de 64 bits de su valor numérico (fullHash). No usa estado global.
+template<class Key>
+class PseudoRandomHashFunction final : public DispersionFunction<Key> {
+public:
+    PseudoRandomHashFunction(unsigned ts) : DispersionFunction<Key>(ts) {}
+    unsigned hash(const Key &key, unsigned ts) const override {
+        return static_cast<unsigned>(fullHash(key) % ts);
+    }
+    unsigned hash(const NumericKey &key, unsigned ts) const override {
+        return static_cast<unsigned>(fullHash(key) % ts);
+    }
+};
+
+// ----------------------------
+// Reducción y mezcla sin división
+// ----------------------------
+
+// Lleva un hash de 64 bits a [0, ts) con una multiplicación en lugar de un
+// módulo: (32 bits altos de h * ts) >> 32. Usa los bits altos, así que h debe
+// estar bien mezclado en ellos.
+inline unsigned fastRange(unsigned long long h, unsigned ts) {
+    return static_cast<unsigned>(((h >> 32) * ts) >> 32);
+}
+
+// Producto completo de 128 bits de a y b plegado a 64 bits (parte alta xor parte
+// baja), el paso de mezcla de wyhash. Sin __int128 se calcula por partes de 32 bits.
+inline unsigned long long mulFold64(unsigned long long a, unsigned long long b) {
+#ifdef __SIZEOF_INT128__
+    unsigned __int128 r = static_cast<unsigned __int128>(a) * b;
+    return static_cast<unsigned long long>(r >> 64) ^ static_cast<unsigned long long>(r);
+#else
+    unsigned long long aLo = a & 0xFFFFFFFFULL, aHi = a >> 32;
+    unsigned long long bLo = b & 0xFFFFFFFFULL, bHi = b >> 32;
+    unsigned long long ll = aLo * bLo, lh = aLo * bHi, hl = aHi * bLo, hh = aHi * bHi;
+    unsigned long long mid = (ll >> 32) + (lh & 0xFFFFFFFFULL) + (hl & 0xFFFFFFFFULL);
+    unsigned long long hi = hh + (lh >> 32) + (hl >> 32) + (mid >> 32);
+    unsigned long long lo = (mid << 32) | (ll & 0xFFFFFFFFULL);
+    return hi ^ lo;
+#endif
+}
+
+// Función de dispersión multiplicativa (multiply-shift).
+// Calcula: h(k) = fastRange(a * valor numérico, tableSize), con a una constante
+// impar de 64 bits. La multiplicación lleva los bits bajos del valor, que son los
+// que cambian entre ID consecutivos, a los bits altos del producto, que son los
+// que usa fastRange. Es la más barata de las funciones de mezcla y no divide.
 template<class Key>
-class PseudoRandomHashFunction : public DispersionFunction<Key> {
+class MultiplyShiftHashFunction final : public DispersionFunction<Key> {
 private:
-    unsigned tableSize;
+    static const unsigned long long multiplier = 0xd6e8feb86659fd93ULL;
+    template<class K>
+    static unsigned position(const K &key, unsigned ts) {
+        return fastRange(static_cast<unsigned long long>(static_cast<long>(key)) * multiplier, ts);
+    }
 public:
-    PseudoRandomHashFunction(unsigned ts) : tableSize(ts) {}
-    unsigned operator()(const Key &key) const {
-        srand(static_cast<unsigned>(static_cast<long>(key)));
-        return rand() % tableSize;
+    MultiplyShiftHashFunction(unsigned ts) : DispersionFunction<Key>(ts) {}
+    unsigned hash(const Key &key, unsigned ts) const override { return position(key, ts); }
+    unsigned hash(const NumericKey &key, unsigned ts) const override { return position(key, ts); }
+};
+
+// Función de dispersión al estilo de wyhash.
+// Calcula: h(k) = fastRange(mulFold64(mulFold64(v xor s0, s1) xor s2, s3), tableSize),
+// es decir, el paso de mezcla de wyhash (producto de 128 bits plegado) aplicado
+// dos veces al valor numérico v con las constantes s0..s3 de wyhash. Cada bit de
+// v afecta a todos los del resultado, como con mix64, sin sus desplazamientos.
+template<class Key>
+class WyHashFunction final : public DispersionFunction<Key> {
+private:
+    template<class K>
+    static unsigned position(const K &key, unsigned ts) {
+        unsigned long long v = static_cast<unsigned long long>(static_cast<long>(key));
+        unsigned long long h = mulFold64(v ^ 0xa0761d6478bd642fULL, 0xe7037ed1a0b428dbULL);
+        return fastRange(mulFold64(h ^ 0x8ebc6af09c88c6e3ULL, 0x589965cc75374cc3ULL), ts);
     }
+public:
+    WyHashFunction(unsigned ts) : DispersionFunction<Key>(ts) {}
+    unsigned hash(const Key &key, unsigned ts) const override { return position(key, ts); }
+    unsigned hash(const NumericKey &key, unsigned ts) const override { return position(key, ts); }
+};
+
+// Función de dispersión de Fibonacci.
+// Calcula: h(k) = (valor numérico * 2^64 / phi) >> (64 - log2(tableSize)), es decir,
+// los log2(tableSize) bits altos del producto por la razón áurea. Solo necesita
+// una multiplicación y un desplazamiento, pero el desplazamiento exige que
+// tableSize sea potencia de dos; con otro tamaño (p. ej. los primos que elige el
+// redimensionado automático) se usa fastRange con el mismo producto.
+template<class Key>
+class FibonacciHashFunction final : public DispersionFunction<Key> {
+private:
+    template<class K>
+    static unsigned position(const K &key, unsigned ts) {
+        unsigned long long h = static_cast<unsigned long long>(static_cast<long>(key)) * SplitMix64::gamma;
+        if((ts & (ts - 1)) != 0) return fastRange(h, ts);
+        // Dos desplazamientos: con ts == 1 el total es 64, que de una vez no está definido.
+        return static_cast<unsigned>(h >> (63 - __builtin_ctz(ts)) >> 1);
+    }
+public:
+    FibonacciHashFunction(unsigned ts) : DispersionFunction<Key>(ts) {}
+    unsigned hash(const Key &key, unsigned ts) const override { return position(key, ts); }
+    unsigned hash(const NumericKey &key, unsigned ts) const override { return position(key, ts); }
+};
+
+// Función de dispersión por mezcla con semilla.
+// Calcula: h(k) = fastRange(mezcla64(hash64(k) xor semilla), tableSize).
+// Es independiente de las anteriores (no reutiliza ni el valor numérico ni
+// fullHash % tableSize) y cada semilla da una función distinta: la dispersión
+// cuckoo la usa como segunda función y la cambia (setSeed) cuando una inserción
+// entra en un ciclo.
+template<class Key>
+class MixHashFunction final : public DispersionFunction<Key> {
+private:
+    unsigned long long seed;
+    unsigned position(unsigned long long h, unsigned ts) const {
+        return fastRange(mix64(h ^ seed), ts);
+    }
+public:
+    static const unsigned long long defaultSeed = 0x2545f4914f6cdd1dULL;
+    MixHashFunction(unsigned ts, unsigned long long seed = defaultSeed)
+    : DispersionFunction<Key>(ts), seed(seed) {}
+    unsigned hash(const Key &key, unsigned ts) const override { return position(fullHash(key), ts); }
+    unsigned hash(const NumericKey &key, unsigned ts) const override { return position(fullHash(key), ts); }
+    unsigned long long getSeed() const { return seed; }
+    void setSeed(unsigned long long s) { seed = s; }
 };
 
 // ----------------------------
 // Funciones de Exploración
 // ----------------------------
 
+template<class Key> class ExplorationFunction;
+
+// Secuencia de exploración con estado: recorre las posiciones
+// (h + g(k, 0)) % tableSize, (h + g(k, 1)) % tableSize, ...
+// avanzando de forma incremental en lugar de recalcular g(k, i) en cada intento.
+// La tabla la obtiene con una sola llamada virtual a ExplorationFunction::probe y
+// después solo usa position() y next(), que no son virtuales.
+template<class Key>
+class ProbeSequence {
+public:
+    enum Kind {
+        LINEAR,       // pos += 1
+        QUADRATIC,    // pos += 2i - 1, ya que i^2 - (i-1)^2 = 2i - 1
+        STRIDE,       // pos += paso precalculado (doble dispersión)
+        REDISPERSION, // pos = h + f(i)(k), f(i) en O(1)
+        GENERIC       // pos = h + g(k, i) llamando a la función de exploración
+    };
+private:
+    Kind kind;
+    unsigned tableSize;
+    unsigned home;            // h % tableSize
+    unsigned pos;             // Posición actual
+    unsigned i;               // Número de intento actual
+    unsigned step;            // Paso (STRIDE)
+    unsigned long long seed;  // Semilla (REDISPERSION)
+    const ExplorationFunction<Key> *fe; // Solo GENERIC
+    const Key *key;                     // Solo GENERIC
+public:
+    ProbeSequence(Kind kind, unsigned h, unsigned ts, unsigned long long param = 0,
+                  const ExplorationFunction<Key> *fe = nullptr, const Key *key = nullptr)
+    : kind(kind), tableSize(ts), home(h % ts), pos(home), i(0),
+      step(static_cast<unsigned>(param % ts)), seed(param), fe(fe), key(key) {
+        if(kind == REDISPERSION || kind == GENERIC)
+            pos = offsetPosition();
+    }
+    unsigned position() const { return pos; }
+    unsigned attempt() const { return i; }
+    void next() {
+        i++;
+        switch(kind) {
+            case LINEAR:
+                pos = (pos + 1 == tableSize) ? 0 : pos + 1;
+                break;
+            case QUADRATIC:
+                pos = static_cast<unsigned>((pos + (2ULL * i - 1)) % tableSize);
+                break;
+            case STRIDE:
+                pos = static_cast<unsigned>((static_cast<unsigned long long>(pos) + step) % tableSize);
+                break;
+            case REDISPERSION:
+            case GENERIC:
+                pos = offsetPosition();
+                break;
+        }
+    }
+private:
+    unsigned offsetPosition() const {
+        unsigned long long offset = (kind == REDISPERSION)
+            ? (SplitMix64::at(seed, i + 1ULL) >> 33)
+            : (*fe)(*key, i);
+        return static_cast<unsigned>((home + offset) % tableSize);
+    }
+};
+
 // Clase base abstracta para las estrategias de exploración.
 // Recibe la clave y el número de intento, y retorna un desplazamiento.
+// probe() devuelve la secuencia de exploración completa de una clave; por defecto
+// llama a operator() en cada intento, y las subclases la redefinen para avanzar
+// de forma incremental. La versión para NumericKey no tiene clave a la que llamar
+// operator(), así que cada subclase debe darla y recorrer las mismas posiciones.
 template<class Key>
 class ExplorationFunction {
 public:
     virtual unsigned operator()(const Key &key, unsigned i) const = 0;
+    virtual ProbeSequence<Key> probe(const Key &key, unsigned h, unsigned tableSize) const {
+        return ProbeSequence<Key>(ProbeSequence<Key>::GENERIC, h, tableSize, 0, this, &key);
+    }
+    virtual ProbeSequence<Key> probe(const NumericKey &key, unsigned h, unsigned tableSize) const = 0;
+    // true si la tabla debe usar la política de inserción Robin Hood.
+    virtual bool robinHood() const { return false; }
     virtual ~ExplorationFunction() {}
 };
 
 // Exploración lineal: g(k, i) = i.
 template<class Key>
-class LinearExploration : public ExplorationFunction<Key> {
+class LinearExploration final : public ExplorationFunction<Key> {
 public:
     unsigned operator()(const Key &key, unsigned i) const {
         (void) key; // No se usa la clave
         return i;
     }
+    ProbeSequence<Key> probe(const Key &key, unsigned h, unsigned tableSize) const {
+        (void) key;
+        return ProbeSequence<Key>(ProbeSequence<Key>::LINEAR, h, tableSize);
+    }
+    ProbeSequence<Key> probe(const NumericKey &key, unsigned h, unsigned tableSize) const {
+        (void) key;
+        return ProbeSequence<Key>(ProbeSequence<Key>::LINEAR, h, tableSize);
+    }
 };
 
 // Exploración cuadrática: g(k, i) = i^2.
 template<class Key>
-class QuadraticExploration : public ExplorationFunction<Key> {
+class QuadraticExploration final : public ExplorationFunction<Key> {
 public:
     unsigned operator()(const Key &key, unsigned i) const {
         (void) key;
         return i * i;
     }
+    ProbeSequence<Key> probe(const Key &key, unsigned h, unsigned tableSize) const {
+        (void) key;
+        return ProbeSequence<Key>(ProbeSequence<Key>::QUADRATIC, h, tableSize);
+    }
+    ProbeSequence<Key> probe(const NumericKey &key, unsigned h, unsigned tableSize) const {
+        (void) key;
+        return ProbeSequence<Key>(ProbeSequence<Key>::QUADRATIC, h, tableSize);
+    }
+};
+
+// Exploración lineal con la política Robin Hood: g(k, i) = i, pero al insertar
+// una clave desplaza a la que esté más cerca de su posición inicial (la "más
+// rica"), y esta sigue buscando sitio más adelante. Así las distancias se igualan,
+// la exploración más larga se mantiene corta incluso con la tabla casi llena y
+// una búsqueda fallida termina en cuanto llega a una celda cuyas claves están
+// más cerca de su inicio de lo que estaría la buscada (ver HashTable).
+template<class Key>
+class RobinHoodExploration final : public ExplorationFunction<Key> {
+public:
+    unsigned operator()(const Key &key, unsigned i) const {
+        (void) key;
+        return i;
+    }
+    ProbeSequence<Key> probe(const Key &key, unsigned h, unsigned tableSize) const {
+        (void) key;
+        return ProbeSequence<Key>(ProbeSequence<Key>::LINEAR, h, tableSize);
+    }
+    ProbeSequence<Key> probe(const NumericKey &key, unsigned h, unsigned tableSize) const {
+        (void) key;
+        return ProbeSequence<Key>(ProbeSequence<Key>::LINEAR, h, tableSize);
+    }
+    bool robinHood() const { return true; }
 };
 
 // Exploración por doble dispersión: g(k, i) = f(k) * i,
 // donde f(k) es una función de dispersión auxiliar.
-template<class Key>
-class DoubleHashExploration : public ExplorationFunction<Key> {
+// Si f(k) es 0 se usa 1, porque un paso nulo visitaría siempre la misma celda.
+// probe() calcula f(k) una sola vez y lo usa como paso.
+// Secondary es el tipo de f; con una función concreta su llamada no es virtual.
+template<class Key, class Secondary = DispersionFunction<Key> >
+class DoubleHashExploration final : public ExplorationFunction<Key> {
 private:
-    DispersionFunction<Key>& secondary;
+    Secondary& secondary;
+    template<class K>
+    unsigned stride(const K &key, unsigned ts) const {
+        unsigned s = secondary.hash(key, ts);
+        return s ? s : 1;
+    }
 public:
-    DoubleHashExploration(DispersionFunction<Key>& sec) : secondary(sec) {}
+    DoubleHashExploration(Secondary& sec) : secondary(sec) {}
     unsigned operator()(const Key &key, unsigned i) const {
-        return secondary(key) * i;
+        return stride(key, secondary.getTableSize()) * i;
+    }
+    // El paso se calcula para el tamaño de la tabla que se explora, no para el
+    // tamaño actual de secondary: así no cambia mientras la tabla se redimensiona.
+    ProbeSequence<Key> probe(const Key &key, unsigned h, unsigned tableSize) const {
+        return ProbeSequence<Key>(ProbeSequence<Key>::STRIDE, h, tableSize, stride(key, tableSize));
+    }
+    ProbeSequence<Key> probe(const NumericKey &key, unsigned h, unsigned tableSize) const {
+        return ProbeSequence<Key>(ProbeSequence<Key>::STRIDE, h, tableSize, stride(key, tableSize));
     }
 };
 
 // Exploración por redispersión: g(k, i) = f(i)(k),
-// se utiliza el generador pseudoaleatorio inicializado con key.
+// f(i) es el (i+1)-ésimo valor de un generador SplitMix64 con semilla key,
+// calculado directamente en O(1) en lugar de generar los i valores anteriores.
+// Se usan 31 bits del valor, el mismo rango que rand().
 template<class Key>
-class RedispersionExploration : public ExplorationFunction<Key> {
+class RedispersionExploration final : public ExplorationFunction<Key> {
 public:
     unsigned operator()(const Key &key, unsigned i) const {
-        srand(static_cast<unsigned>(static_cast<long>(key)));
-        unsigned offset = 0;
-        for(unsigned j = 0; j <= i; j++){
-            offset = rand();
-        }
-        return offset;
+        return static_cast<unsigned>(SplitMix64::at(seed(key), i + 1ULL) >> 33);
+    }
+    ProbeSequence<Key> probe(const Key &key, unsigned h, unsigned tableSize) const {
+        return ProbeSequence<Key>(ProbeSequence<Key>::REDISPERSION, h, tableSize, seed(key));
+    }
+    ProbeSequence<Key> probe(const NumericKey &key, unsigned h, unsigned tableSize) const {
+        return ProbeSequence<Key>(ProbeSequence<Key>::REDISPERSION, h, tableSize, seed(key));
+    }
+private:
+    template<class K>
+    static unsigned long long seed(const K &key) {
+        return static_cast<unsigned long long>(static_cast<long>(key));
+    }
+};
+
+// Construye una función de exploración de tipo concreto Fe a partir de la de
+// dispersión Fd (solo la doble dispersión la necesita). Sirve para instanciar
+// HashTable con las clases concretas como parámetros.
+template<class Fe>
+struct ExplorationMaker {
+    template<class Fd>
+    static Fe make(Fd &) { return Fe(); }
+};
+template<class Key, class Fd>
+struct ExplorationMaker<DoubleHashExploration<Key, Fd> > {
+    static DoubleHashExploration<Key, Fd> make(Fd &fd) {
+        return DoubleHashExploration<Key, Fd>(fd);
     }
 };
 
@@ -2,139 +2,2315 @@
 #define HASHTABLE_HPP
 
 #include <vector>
+#include <cstdlib>
 #include "HashFunctions.hpp" // Ahora incluye la definición de persona y funciones de dispersión/exploración
 #include <list>
+#include <new>
+#include <cstddef>
+#include <utility>
+#include <algorithm>
+#include <mutex>
+#include <atomic>
+#include <thread>
+#ifdef __SSE2__
+#include <emmintrin.h>
+#endif
 
 // ----------------------------
 // Clases de Secuencias
 // ----------------------------
 
+// Comparación de una clave guardada con la buscada: otra Key se compara con ==
+// y una NumericKey coincide con las claves de su mismo valor numérico.
+template<class Key>
+bool keyMatches(const Key &stored, const Key &key) { return stored == key; }
+template<class Key>
+bool keyMatches(const Key &stored, const NumericKey &key) {
+    return static_cast<long>(stored) == static_cast<long>(key);
+}
+
+// ----------------------------
+// Huellas (tags)
+// ----------------------------
+// Las secuencias de dispersión cerrada e inlineSequence guardan, en un array
+// aparte de las claves, una huella de 7 bits del hash de cada clave. Una búsqueda
+// compara primero las huellas de toda la celda (16 a la vez con SSE2) y solo
+// compara las claves cuya huella coincide, de modo que casi ninguna comparación
+// negativa lee la clave.
+
+// Huella de una clave: los 7 bits altos de su hash de 64 bits.
+template<class K>
+unsigned char keyTag(const K &key) {
+    return static_cast<unsigned char>(fullHash(key) >> 57);
+}
+
+// Relleno del array de huellas de una celda de n huecos: la búsqueda con SSE2
+// lee grupos completos de 16 huellas.
+inline unsigned tagCapacity(unsigned n) { return (n + 15) & ~15u; }
+
+// Devuelve el primer hueco i de [0, n) con tags[i] == tag para el que match(i)
+// es cierto, o n si no hay ninguno. tags debe poder leerse hasta tagCapacity(n)
+// (lo que haya tras los n primeros se ignora).
+template<class F>
+unsigned findTag(const unsigned char *tags, unsigned n, unsigned char tag, F match) {
+#ifdef __SSE2__
+    const __m128i wanted = _mm_set1_epi8(static_cast<char>(tag));
+    for(unsigned base = 0; base < n; base += 16) {
+        __m128i group = _mm_loadu_si128(reinterpret_cast<const __m128i*>(tags + base));
+        unsigned mask = static_cast<unsigned>(_mm_movemask_epi8(_mm_cmpeq_epi8(group, wanted)));
+        if(n - base < 16) mask &= (1u << (n - base)) - 1;
+        while(mask != 0) {
+            unsigned i = base + __builtin_ctz(mask);
+            if(match(i)) return i;
+            mask &= mask - 1;
+        }
+    }
+#else
+    for(unsigned i = 0; i < n; i++) {
+        if(tags[i] == tag && match(i)) return i;
+    }
+#endif
+    return n;
+}
+
 // Clase base abstracta para una secuencia (celda de la tabla hash)
+// Las secuencias concretas son final para que las llamadas desde la tabla,
+// que conoce su tipo exacto, no pasen por la tabla virtual.
 template<class Key>
 class Sequence {
 public:
     virtual bool search(const Key &key) const = 0;
     virtual bool insert(const Key &key) = 0;
+    // Elimina una aparición de key. Devuelve false si no estaba.
+    virtual bool erase(const Key &key) = 0;
     virtual ~Sequence() {}
 };
 
 // Secuencia dinámica para dispersión abierta (usa std::list)
 template<class Key>
-class dynamicSequence : public Sequence<Key> {
+class dynamicSequence final : public Sequence<Key> {
 private:
     std::list<Key> data;
 public:
-    bool search(const Key &key) const override {
-        for(const auto &elem : data) {
-            if(elem == key) return true;
+    bool search(const Key &key) const override { return find(key) != nullptr; }
+    // Clave guardada que coincide con key (Key o NumericKey), o nullptr.
+    template<class K>
+    Key* find(const K &key) {
+        for(auto &elem : data) {
+            if(keyMatches(elem, key)) return &elem;
         }
-        return false;
+        return nullptr;
+    }
+    template<class K>
+    const Key* find(const K &key) const {
+        return const_cast<dynamicSequence*>(this)->find(key);
     }
     bool insert(const Key &key) override {
         data.push_back(key);
         return true;
     }
+    bool erase(const Key &key) override {
+        for(auto it = data.begin(); it != data.end(); ++it) {
+            if(*it == key) {
+                data.erase(it);
+                return true;
+            }
+        }
+        return false;
+    }
+    unsigned size() const { return static_cast<unsigned>(data.size()); }
+    void clear() { data.clear(); }
+    // Aplica f a cada clave de la secuencia.
+    template<class F>
+    void forEach(F f) const {
+        for(const auto &elem : data) f(elem);
+    }
+};
+
+// Huecos en línea por defecto de inlineSequence para claves de keySize bytes:
+// los que caben en una línea de caché (64 bytes), al menos 1 y como mucho 16 (un
+// grupo de huellas). Cada celda vacía ocupa esos huecos, así que con claves
+// grandes solo la primera va en línea: con persona (144 bytes) una celda ocupa
+// unos 200 bytes, lo mismo que una lista (dynamicSequence) con un solo nodo.
+constexpr unsigned inlineSlots(size_t keySize) {
+    return keySize >= 64 ? 1 : (64 / keySize > 16 ? 16 : 64 / keySize);
+}
+
+// Secuencia para dispersión abierta con las N primeras claves en línea y el resto
+// en un vector de desbordamiento. Guardada por valor en la tabla, una búsqueda en
+// una cadena de hasta N claves no sigue ningún puntero ni reserva memoria al insertar.
+// Las claves en línea llevan huella (ver findTag); las desbordadas no.
+template<class Key, unsigned N = inlineSlots(sizeof(Key))>
+class inlineSequence final : public Sequence<Key> {
+private:
+    unsigned char tags[(N + 15) & ~15u]; // tagCapacity(N)
+    unsigned count;
+    Key slots[N];
+    std::vector<Key> overflow;
+    Key& at(unsigned i) { return i < N ? slots[i] : overflow[i - N]; }
+    // Posición de la clave que coincide con key (menor que N si está en slots,
+    // N + j si es overflow[j]), o count si no está.
+    template<class K>
+    unsigned position(const K &key) const {
+        if(count == 0) return count;
+        unsigned inlined = count < N ? count : N;
+        unsigned i = findTag(tags, inlined, keyTag(key),
+                             [&](unsigned j) { return keyMatches(slots[j], key); });
+        if(i < inlined) return i;
+        for(unsigned j = 0; j < overflow.size(); j++) {
+            if(keyMatches(overflow[j], key)) return N + j;
+        }
+        return count;
+    }
+public:
+    inlineSequence() : tags(), count(0) {}
+    bool search(const Key &key) const override { return find(key) != nullptr; }
+    // Clave guardada que coincide con key (Key o NumericKey), o nullptr.
+    template<class K>
+    Key* find(const K &key) {
+        unsigned i = position(key);
+        return i < count ? &at(i) : nullptr;
+    }
+    template<class K>
+    const Key* find(const K &key) const {
+        return const_cast<inlineSequence*>(this)->find(key);
+    }
+    bool insert(const Key &key) override {
+        if(count < N) {
+            slots[count] = key;
+            tags[count] = keyTag(key);
+        } else {
+            overflow.push_back(key);
+        }
+        count++;
+        return true;
+    }
+    // La última clave ocupa el lugar de la borrada.
+    bool erase(const Key &key) override {
+        unsigned i = position(key);
+        if(i == count) return false;
+        unsigned last = count - 1;
+        if(i < N)
+            tags[i] = keyTag(at(last));
+        at(i) = at(last);
+        if(last >= N) overflow.pop_back();
+        else slots[last] = Key();
+        count--;
+        return true;
+    }
+    unsigned size() const { return count; }
+    void clear() {
+        for(unsigned i = 0; i < count && i < N; i++) slots[i] = Key();
+        overflow.clear();
+        count = 0;
+    }
+    // Aplica f a cada clave de la secuencia.
+    template<class F>
+    void forEach(F f) const {
+        for(unsigned i = 0; i < count && i < N; i++) f(slots[i]);
+        for(const auto &elem : overflow) f(elem);
+    }
 };
 
 // Secuencia estática para dispersión cerrada (usa std::vector)
+//
+// Borrado con lápidas: al eliminar una clave de una celda que se ha llenado su
+// hueco queda marcado (tombstones) para que la celda siga contando como llena
+// (wasFull) y las búsquedas de claves que se desbordaron a celdas posteriores no
+// se corten aquí. Si la celda nunca se ha llenado ninguna clave ha pasado de
+// largo y no hace falta lápida. Una inserción puede reutilizar el hueco, y
+// clear() (al reconstruir la tabla) quita las lápidas.
+// Cada hueco tiene su huella en tags (ver findTag) y su distancia de exploración
+// para la política Robin Hood (ver HashTable).
 template<class Key>
-class staticSequence : public Sequence<Key> {
+class staticSequence final : public Sequence<Key> {
 private:
     std::vector<Key> data;
+    std::vector<unsigned char> tags; // tagCapacity(blockSize) huellas
+    std::vector<unsigned> distances;
     unsigned blockSize;
+    unsigned tombstones;
+    unsigned maxDist;                // Mayor distancia guardada desde clear()
 public:
-    staticSequence(unsigned bs) : blockSize(bs) {}
-    bool search(const Key &key) const override {
-        for(const auto &elem : data) {
-            if(elem == key) return true;
-        }
-        return false;
+    staticSequence(unsigned bs)
+    : tags(tagCapacity(bs)), distances(bs), blockSize(bs), tombstones(0), maxDist(0) {}
+    bool search(const Key &key) const override { return find(key) != nullptr; }
+    // Clave guardada que coincide con key (Key o NumericKey), o nullptr.
+    template<class K>
+    Key* find(const K &key) {
+        unsigned n = size();
+        if(n == 0) return nullptr;
+        unsigned i = findTag(tags.data(), n, keyTag(key),
+                             [&](unsigned j) { return keyMatches(data[j], key); });
+        return i < n ? &data[i] : nullptr;
     }
-    bool insert(const Key &key) override {
+    template<class K>
+    const Key* find(const K &key) const {
+        return const_cast<staticSequence*>(this)->find(key);
+    }
+    bool insert(const Key &key) override { return insert(key, 0); }
+    // Inserta key a distance celdas de su posición inicial.
+    bool insert(const Key &key, unsigned distance) {
         if(isFull()) return false;
+        if(wasFull()) tombstones--;
+        tags[data.size()] = keyTag(key);
+        distances[data.size()] = distance;
+        if(distance > maxDist) maxDist = distance;
         data.push_back(key);
         return true;
     }
+    // Robin Hood: hueco con la menor distancia, su distancia, e intercambio de
+    // su clave y distancia por las dadas.
+    unsigned richest() const {
+        unsigned best = 0;
+        for(unsigned i = 1; i < data.size(); i++)
+            if(distances[i] < distances[best]) best = i;
+        return best;
+    }
+    unsigned distance(unsigned i) const { return distances[i]; }
+    void exchange(unsigned i, Key &key, unsigned &distance) {
+        std::swap(data[i], key);
+        std::swap(distances[i], distance);
+        tags[i] = keyTag(data[i]);
+        if(distances[i] > maxDist) maxDist = distances[i];
+    }
+    // Mayor distancia que ha tenido una clave de la celda (no baja al borrar).
+    unsigned maxDistance() const { return maxDist; }
+    bool erase(const Key &key) override {
+        for(unsigned i = 0; i < data.size(); i++) {
+            if(data[i] == key) {
+                data[i] = data.back();
+                tags[i] = tags[data.size() - 1];
+                distances[i] = distances[data.size() - 1];
+                bool full = wasFull();
+                data.pop_back();
+                if(full) tombstones++;
+                return true;
+            }
+        }
+        return false;
+    }
+    // Sin huecos libres para insertar.
     bool isFull() const {
         return data.size() >= blockSize;
     }
+    // Llena contando las lápidas: la exploración de una búsqueda sigue adelante.
+    bool wasFull() const {
+        return data.size() + tombstones >= blockSize;
+    }
+    unsigned size() const { return static_cast<unsigned>(data.size()); }
+    unsigned tombstoneCount() const { return tombstones; }
+    void clear() {
+        data.clear();
+        tombstones = 0;
+        maxDist = 0;
+    }
+    // Aplica f a cada clave de la secuencia.
+    template<class F>
+    void forEach(F f) const {
+        for(const auto &elem : data) f(elem);
+    }
+};
+
+// Ocupación de una celda plana: huecos ocupados, lápidas y mayor distancia
+// guardada (ver staticSequence).
+struct FlatCell {
+    unsigned count;
+    unsigned tombstones;
+    unsigned maxDistance;
+};
+
+// Secuencia plana para dispersión cerrada.
+// Es una vista (no propietaria) de una celda dentro del array contiguo que
+// reserva BucketStorage<Key, flatSequence<Key> >: blockSize huecos consecutivos
+// y la ocupación de la celda. Usada como Container de HashTable selecciona ese
+// almacenamiento plano. El borrado usa lápidas igual que staticSequence y las
+// huellas y las distancias de la celda están en arrays aparte (ver findTag).
+template<class Key>
+class flatSequence final : public Sequence<Key> {
+private:
+    Key *slots;
+    unsigned char *tags;
+    unsigned *distances;
+    FlatCell *cell;
+    unsigned blockSize;
+public:
+    flatSequence(Key *slots, unsigned char *tags, unsigned *distances, FlatCell *cell, unsigned bs)
+    : slots(slots), tags(tags), distances(distances), cell(cell), blockSize(bs) {}
+    bool search(const Key &key) const override { return find(key) != nullptr; }
+    // Clave guardada que coincide con key (Key o NumericKey), o nullptr.
+    // La vista no es propietaria: el puntero es a la tabla.
+    template<class K>
+    Key* find(const K &key) const {
+        unsigned n = cell->count;
+        if(n == 0) return nullptr;
+        unsigned i = findTag(tags, n, keyTag(key),
+                             [&](unsigned j) { return keyMatches(slots[j], key); });
+        return i < n ? slots + i : nullptr;
+    }
+    bool insert(const Key &key) override { return insert(key, 0); }
+    bool insert(const Key &key, unsigned distance) {
+        if(isFull()) return false;
+        if(wasFull()) cell->tombstones--;
+        tags[cell->count] = keyTag(key);
+        distances[cell->count] = distance;
+        if(distance > cell->maxDistance) cell->maxDistance = distance;
+        new (slots + cell->count) Key(key);
+        cell->count++;
+        return true;
+    }
+    unsigned richest() const {
+        unsigned best = 0;
+        for(unsigned i = 1; i < cell->count; i++)
+            if(distances[i] < distances[best]) best = i;
+        return best;
+    }
+    unsigned distance(unsigned i) const { return distances[i]; }
+    void exchange(unsigned i, Key &key, unsigned &distance) const {
+        std::swap(slots[i], key);
+        std::swap(distances[i], distance);
+        tags[i] = keyTag(slots[i]);
+        if(distances[i] > cell->maxDistance) cell->maxDistance = distances[i];
+    }
+    unsigned maxDistance() const { return cell->maxDistance; }
+    bool erase(const Key &key) override {
+        for(unsigned i = 0; i < cell->count; i++) {
+            if(slots[i] == key) {
+                unsigned last = cell->count - 1;
+                if(i != last) {
+                    slots[i] = slots[last];
+                    tags[i] = tags[last];
+                    distances[i] = distances[last];
+                }
+                bool full = wasFull();
+                slots[last].~Key();
+                cell->count--;
+                if(full) cell->tombstones++;
+                return true;
+            }
+        }
+        return false;
+    }
+    bool isFull() const {
+        return cell->count >= blockSize;
+    }
+    bool wasFull() const {
+        return cell->count + cell->tombstones >= blockSize;
+    }
+    unsigned size() const { return cell->count; }
+    unsigned tombstoneCount() const { return cell->tombstones; }
+    void clear() {
+        for(unsigned i = 0; i < cell->count; i++) slots[i].~Key();
+        cell->count = 0;
+        cell->tombstones = 0;
+        cell->maxDistance = 0;
+    }
+    // Vacía la celda dejando una lápida por clave, así que sigue contando como
+    // llena si lo estaba (ver BucketStorage::vacate).
+    void vacate() {
+        for(unsigned i = 0; i < cell->count; i++) slots[i].~Key();
+        cell->tombstones += cell->count;
+        cell->count = 0;
+    }
+    // Aplica f a cada clave de la secuencia.
+    template<class F>
+    void forEach(F f) const {
+        for(unsigned i = 0; i < cell->count; i++) f(slots[i]);
+    }
 };
 
 // ----------------------------
 // Tabla Hash Genérica
 // ----------------------------
 
-// Versión general para dispersión cerrada (usa staticSequence)
-template<class Key, class Container = staticSequence<Key> >
-class HashTable : public Sequence<Key> {
+// Contadores de exploración de la dispersión cerrada: número de operaciones
+// (inserciones y búsquedas), número total de celdas visitadas por ellas y
+// longitud de la exploración más larga. last es la de la última operación.
+// Como TableStats, solo se actualizan si se compila con HASH_STATS; si no,
+// record está vacía y probeStats() devuelve siempre ceros.
+struct ProbeStats {
+    unsigned long operations;
+    unsigned long probes;
+    unsigned maxProbes;
+    unsigned last;
+    ProbeStats() : operations(0), probes(0), maxProbes(0), last(0) {}
+    double average() const { return operations ? static_cast<double>(probes) / operations : 0.0; }
+#ifdef HASH_STATS
+    void record(unsigned length) {
+        operations++;
+        probes += length;
+        last = length;
+        if(length > maxProbes) maxProbes = length;
+    }
+#else
+    void record(unsigned) {}
+#endif
+};
+
+// Contadores de uso de una tabla (statistics()): inserciones, búsquedas y
+// borrados, celdas visitadas por cada tipo de operación, colisiones (claves
+// nuevas que no se han quedado en su celda inicial o que comparten cadena) e
+// histograma de longitudes de exploración (probeHistogram[i]: operaciones que
+// han visitado i + 1 celdas; la última posición acumula las más largas).
+// Solo se actualizan si se compila con HASH_STATS (make STATS=1); si no, las
+// funciones record* están vacías y el compilador elimina las llamadas.
+struct TableStats {
+    static const unsigned histogramSize = 16;
+    unsigned long inserts, insertProbes, collisions;
+    unsigned long searches, hits, searchProbes;
+    unsigned long erases;
+    unsigned long probeHistogram[histogramSize];
+
+    TableStats() : inserts(0), insertProbes(0), collisions(0), searches(0), hits(0),
+                   searchProbes(0), erases(0) {
+        for(unsigned i = 0; i < histogramSize; i++) probeHistogram[i] = 0;
+    }
+    static bool enabled() {
+#ifdef HASH_STATS
+        return true;
+#else
+        return false;
+#endif
+    }
+#ifdef HASH_STATS
+    void recordInsert(unsigned probes, bool collided) {
+        inserts++;
+        insertProbes += probes;
+        if(collided) collisions++;
+        recordLength(probes);
+    }
+    void recordSearch(unsigned probes, bool found) {
+        searches++;
+        searchProbes += probes;
+        if(found) hits++;
+        recordLength(probes);
+    }
+    void recordErase() { erases++; }
+private:
+    void recordLength(unsigned probes) {
+        probeHistogram[probes == 0 ? 0 : (probes < histogramSize ? probes : histogramSize) - 1]++;
+    }
+#else
+    void recordInsert(unsigned, bool) {}
+    void recordSearch(unsigned, bool) {}
+    void recordErase() {}
+#endif
+};
+
+// Histograma de ocupación de storage (ts celdas): result[k] es el número de
+// celdas con k claves (longitud de la cadena en la dispersión abierta). Se
+// calcula recorriendo la tabla, así que no depende de HASH_STATS.
+template<class Storage>
+std::vector<unsigned long> occupancyHistogram(const Storage &storage, unsigned ts) {
+    std::vector<unsigned long> histogram;
+    for(unsigned pos = 0; pos < ts; pos++) {
+        unsigned n = storage[pos].size();
+        if(n >= histogram.size()) histogram.resize(n + 1, 0);
+        histogram[n]++;
+    }
+    return histogram;
+}
+
+// ----------------------------
+// Almacenamiento de las celdas
+// ----------------------------
+
+// Versión general: una celda Container (p. ej. staticSequence) reservada por separado
+// para cada posición la primera vez que se usa. El array de punteros se pide a
+// cero (calloc), así que crear una tabla no recorre sus celdas ni hace una reserva
+// por celda y el crecimiento no detiene la inserción que lo provoca.
+// table[pos] devuelve la celda, construyéndola si hace falta; a través de una
+// referencia const una celda sin construir se ve vacía y no se construye.
+// vacate(pos) libera la celda pos durante un traslado incremental, de modo que la
+// tabla antigua se destruye poco a poco. La sustituye una celda compartida sin
+// claves que cuenta como llena (wasFull) si la liberada lo hacía.
+template<class Key, class Container>
+class BucketStorage {
+private:
+    unsigned tableSize;
+    unsigned blockSize;
+    Container **cells; // nullptr: sin construir
+
+    // Celdas compartidas que ocupan el lugar de las liberadas: filled no tiene
+    // huecos (siempre llena) y empty nunca se llena. Nadie inserta en ellas.
+    static Container& filled() { static Container cell(0); return cell; }
+    static Container& empty() { static Container cell(1); return cell; }
+    static bool shared(const Container *cell) { return cell == &filled() || cell == &empty(); }
+public:
+    BucketStorage(unsigned ts, unsigned bs)
+    : tableSize(ts), blockSize(bs),
+      cells(static_cast<Container**>(std::calloc(ts != 0 ? ts : 1, sizeof(Container*)))) {
+        if(cells == nullptr) throw std::bad_alloc();
+    }
+    ~BucketStorage(){
+        for(unsigned i = 0; i < tableSize; i++)
+            if(!shared(cells[i])) delete cells[i];
+        std::free(cells);
+    }
+    BucketStorage(const BucketStorage&) = delete;
+    BucketStorage& operator=(const BucketStorage&) = delete;
+    void swap(BucketStorage &other) {
+        std::swap(tableSize, other.tableSize);
+        std::swap(blockSize, other.blockSize);
+        std::swap(cells, other.cells);
+    }
+    Container& operator[](unsigned pos) {
+        if(cells[pos] == nullptr) cells[pos] = new Container(blockSize);
+        return *cells[pos];
+    }
+    const Container& operator[](unsigned pos) const {
+        return cells[pos] != nullptr ? *cells[pos] : empty();
+    }
+    void vacate(unsigned pos) {
+        Container *cell = cells[pos];
+        cells[pos] = cell != nullptr && cell->wasFull() ? &filled() : &empty();
+        if(!shared(cell)) delete cell;
+    }
+    // Pide al procesador que traiga la celda pos a caché (ver search_batch).
+    void prefetch(unsigned pos) const { __builtin_prefetch(cells[pos]); }
+};
+
+// Almacenamiento plano: todos los huecos (tableSize * blockSize) en un único bloque
+// alineado a línea de caché, precedido por la ocupación (FlatCell) de cada celda
+// y por las huellas de todos los huecos, también seguidas (la búsqueda puede leer
+// las de la celda siguiente, que descarta; al final hay 16 bytes de relleno),
+// y sus distancias de exploración.
+// Se hace una sola reserva de memoria, pedida a cero (calloc) para no recorrer las
+// celdas al crear la tabla, y una secuencia de exploración recorre memoria
+// contigua. table[pos] devuelve una flatSequence que apunta a la celda.
+// vacate(pos) destruye las claves de la celda pos durante un traslado
+// incremental (ver flatSequence::vacate).
+template<class Key>
+class BucketStorage<Key, flatSequence<Key> > {
 private:
+    static const size_t cacheLine = 64;
     unsigned tableSize;
     unsigned blockSize;
-    std::vector<Container*> table;
-    DispersionFunction<Key>& fd;
-    ExplorationFunction<Key>& fe;
+    void *memory;     // Bloque reservado (sin alinear)
+    FlatCell *cells;  // tableSize celdas
+    unsigned char *tags; // tableSize * blockSize huellas
+    unsigned *distances; // tableSize * blockSize distancias
+    Key *slots;       // tableSize * blockSize huecos, alineados a cacheLine
+
+    static size_t alignUp(size_t n) { return (n + cacheLine - 1) & ~(cacheLine - 1); }
+public:
+    BucketStorage(unsigned ts, unsigned bs) : tableSize(ts), blockSize(bs) {
+        size_t cellsBytes = alignUp(sizeof(FlatCell) * ts);
+        size_t tagsBytes = alignUp(static_cast<size_t>(ts) * bs + 16);
+        size_t distancesBytes = alignUp(sizeof(unsigned) * ts * bs);
+        size_t slotsBytes = sizeof(Key) * ts * bs;
+        // Una FlatCell a cero es una celda vacía.
+        memory = std::calloc(1, cellsBytes + tagsBytes + distancesBytes + slotsBytes + cacheLine);
+        if(memory == nullptr) throw std::bad_alloc();
+        char *base = reinterpret_cast<char*>(alignUp(reinterpret_cast<size_t>(memory)));
+        cells = reinterpret_cast<FlatCell*>(base);
+        tags = reinterpret_cast<unsigned char*>(base + cellsBytes);
+        distances = reinterpret_cast<unsigned*>(base + cellsBytes + tagsBytes);
+        slots = reinterpret_cast<Key*>(base + cellsBytes + tagsBytes + distancesBytes);
+    }
+    ~BucketStorage(){
+        // Solo se construyen los huecos ocupados.
+        for(unsigned i = 0; i < tableSize; i++)
+            for(unsigned j = 0; j < cells[i].count; j++)
+                slots[static_cast<size_t>(i) * blockSize + j].~Key();
+        std::free(memory);
+    }
+    BucketStorage(const BucketStorage&) = delete;
+    BucketStorage& operator=(const BucketStorage&) = delete;
+    void swap(BucketStorage &other) {
+        std::swap(tableSize, other.tableSize);
+        std::swap(blockSize, other.blockSize);
+        std::swap(memory, other.memory);
+        std::swap(cells, other.cells);
+        std::swap(tags, other.tags);
+        std::swap(distances, other.distances);
+        std::swap(slots, other.slots);
+    }
+    flatSequence<Key> operator[](unsigned pos) const {
+        return flatSequence<Key>(slots + static_cast<size_t>(pos) * blockSize,
+                                 tags + static_cast<size_t>(pos) * blockSize,
+                                 distances + static_cast<size_t>(pos) * blockSize,
+                                 cells + pos, blockSize);
+    }
+    void vacate(unsigned pos) { (*this)[pos].vacate(); }
+    // Trae a caché la ocupación, las huellas y el primer hueco de la celda pos.
+    void prefetch(unsigned pos) const {
+        size_t first = static_cast<size_t>(pos) * blockSize;
+        __builtin_prefetch(cells + pos);
+        __builtin_prefetch(tags + first);
+        __builtin_prefetch(slots + first);
+    }
+};
+
+// Celdas de la dispersión abierta (Chain: dynamicSequence o inlineSequence),
+// guardadas por valor en un único bloque pedido a cero (calloc) y construidas la
+// primera vez que se usan, como las de BucketStorage: crear una tabla no recorre
+// sus celdas. built[pos] indica si la celda pos está construida; a través de una
+// referencia const una celda sin construir se ve vacía. vacate(pos) destruye la
+// celda pos durante un traslado incremental.
+template<class Chain>
+class ChainStorage {
+private:
+    unsigned tableSize;
+    Chain *cells;
+    unsigned char *built;
+
+    static const Chain& none() { static const Chain cell = Chain(); return cell; }
 public:
-    HashTable(unsigned ts, DispersionFunction<Key>& dispFunc, ExplorationFunction<Key>& explFunc, unsigned bs)
-    : tableSize(ts), blockSize(bs), fd(dispFunc), fe(explFunc) {
-        table.resize(tableSize, nullptr);
-        for(unsigned i = 0; i < tableSize; i++){
-            table[i] = new Container(blockSize);
+    explicit ChainStorage(unsigned ts = 0)
+    : tableSize(ts), cells(static_cast<Chain*>(std::calloc(ts != 0 ? ts : 1, sizeof(Chain)))),
+      built(static_cast<unsigned char*>(std::calloc(ts != 0 ? ts : 1, 1))) {
+        if(cells == nullptr || built == nullptr) {
+            std::free(cells);
+            std::free(built);
+            throw std::bad_alloc();
         }
     }
-    ~HashTable(){
-        for(auto ptr : table)
-            delete ptr;
+    ~ChainStorage() {
+        for(unsigned i = 0; i < tableSize; i++)
+            if(built[i]) cells[i].~Chain();
+        std::free(cells);
+        std::free(built);
     }
-    bool search(const Key &key) const override {
-        unsigned h = fd(key);
-        unsigned maxAttempts = tableSize;
-        for(unsigned i = 0; i < maxAttempts; i++){
-            unsigned pos = (h + fe(key, i)) % tableSize;
-            if(table[pos]->search(key))
+    ChainStorage(const ChainStorage&) = delete;
+    ChainStorage& operator=(const ChainStorage&) = delete;
+    void swap(ChainStorage &other) {
+        std::swap(tableSize, other.tableSize);
+        std::swap(cells, other.cells);
+        std::swap(built, other.built);
+    }
+    unsigned size() const { return tableSize; }
+    bool empty() const { return tableSize == 0; }
+    Chain& operator[](unsigned pos) {
+        if(!built[pos]) {
+            new (cells + pos) Chain();
+            built[pos] = 1;
+        }
+        return cells[pos];
+    }
+    const Chain& operator[](unsigned pos) const { return built[pos] ? cells[pos] : none(); }
+    void vacate(unsigned pos) {
+        if(built[pos]) cells[pos].~Chain();
+        built[pos] = 0;
+    }
+    void prefetch(unsigned pos) const { __builtin_prefetch(cells + pos); }
+};
+
+// ----------------------------
+// Tabla Hash
+// ----------------------------
+
+// Resultado de HashTable::insertUnique.
+enum InsertResult {
+    INSERTED, // La clave era nueva y se ha insertado
+    PRESENT,  // Ya estaba: la tabla no cambia
+    NO_ROOM   // No cabe (sin redimensionado automático)
+};
+
+// Menor número primo >= n. Los tamaños que elige el redimensionado automático
+// son primos para que la función módulo siga repartiendo bien.
+inline unsigned nextPrime(unsigned n) {
+    if(n <= 2) return 2;
+    if(n % 2 == 0) n++;
+    for(;; n += 2) {
+        bool prime = true;
+        for(unsigned d = 3; static_cast<unsigned long>(d) * d <= n; d += 2) {
+            if(n % d == 0) { prime = false; break; }
+        }
+        if(prime) return n;
+    }
+}
+
+// ----------------------------
+// Carga masiva y operaciones por lotes
+// ----------------------------
+
+// Claves por grupo en search_batch e insert_batch: las celdas de un grupo se
+// piden a caché a la vez, así que no conviene que sean más de las que caben en
+// vuelo en el procesador.
+const unsigned batchWindow = 16;
+
+// Hilos para una carga masiva: threads, o los del procesador si es 0.
+inline unsigned bulkThreads(unsigned threads) {
+    if(threads != 0) return threads;
+    return std::max(1u, std::thread::hardware_concurrency());
+}
+
+// Ejecuta work(t) para t = 0..threads-1, cada uno en un hilo (el 0 en el que llama).
+template<class F>
+void runParallel(unsigned threads, F work) {
+    std::vector<std::thread> workers;
+    for(unsigned t = 1; t < threads; t++)
+        workers.emplace_back(work, t);
+    work(0);
+    for(std::thread &worker : workers) worker.join();
+}
+
+// Reparto de las claves de una carga masiva. Las celdas se dividen en
+// partitions rangos contiguos de cellsPer celdas (el último puede ser menor).
+// home[i] es la celda inicial de la clave i y order tiene los índices de las
+// claves agrupados por partición: los de la partición p están en
+// order[start[p], start[p + 1]), en el orden de la entrada.
+struct BulkPartition {
+    unsigned partitions;
+    unsigned cellsPer;
+    std::vector<unsigned> home;
+    std::vector<size_t> order;
+    std::vector<size_t> start;
+
+    unsigned begin(unsigned p) const { return p * cellsPer; }
+    unsigned end(unsigned p, unsigned ts) const { return ts - begin(p) > cellsPer ? begin(p) + cellsPer : ts; }
+};
+
+// Calcula en paralelo home[i] = hash(i) para las n claves y las agrupa por
+// partición con una ordenación por recuento (radix de un solo dígito, la
+// partición): cada hilo cuenta las claves de su tramo en cada partición, las
+// sumas prefijas le dan su sitio dentro de cada una y cada hilo copia sus
+// índices sin sincronizarse con los demás.
+template<class Hash>
+void partitionKeys(size_t n, unsigned ts, unsigned partitions, unsigned threads,
+                   Hash hash, BulkPartition &out) {
+    out.cellsPer = (ts + partitions - 1) / partitions;
+    out.partitions = (ts + out.cellsPer - 1) / out.cellsPer;
+    const unsigned parts = out.partitions;
+    const unsigned cellsPer = out.cellsPer;
+    out.home.assign(n, 0);
+    out.order.assign(n, 0);
+    out.start.assign(parts + 1, 0);
+    std::vector<size_t> counts(static_cast<size_t>(threads) * parts, 0);
+    runParallel(threads, [&](unsigned t) {
+        size_t *mine = &counts[static_cast<size_t>(t) * parts];
+        for(size_t i = n * t / threads; i < n * (t + 1) / threads; i++) {
+            out.home[i] = hash(i);
+            mine[out.home[i] / cellsPer]++;
+        }
+    });
+    size_t offset = 0;
+    for(unsigned p = 0; p < parts; p++) {
+        out.start[p] = offset;
+        for(unsigned t = 0; t < threads; t++) {
+            size_t &c = counts[static_cast<size_t>(t) * parts + p];
+            size_t tally = c;
+            c = offset;
+            offset += tally;
+        }
+    }
+    out.start[parts] = offset;
+    runParallel(threads, [&](unsigned t) {
+        size_t *next = &counts[static_cast<size_t>(t) * parts];
+        for(size_t i = n * t / threads; i < n * (t + 1) / threads; i++)
+            out.order[next[out.home[i] / cellsPer]++] = i;
+    });
+}
+
+// Versión general para dispersión cerrada (usa staticSequence o flatSequence)
+//
+// Fd y Fe son los tipos de la función de dispersión y de exploración. Por defecto
+// son las clases base abstractas y la función concreta se elige en ejecución.
+// Si se indican las clases concretas (que son final), p. ej.
+//   HashTable<persona, flatSequence<persona>, ModuleHashFunction<persona>, LinearExploration<persona> >
+// todas las llamadas se resuelven en compilación y el compilador puede expandirlas en línea.
+//
+// Redimensionado: con setMaxLoadFactor(f), f > 0, cuando una inserción dejaría el
+// factor de carga (claves / (tableSize * blockSize)) por encima de f, o cuando no
+// encuentra hueco, la tabla pasa a tener el primo >= 2 * tableSize + 1 celdas y
+// reinserta todas las claves. rehash(n) permite cambiar el tamaño a mano (también
+// a menos celdas). Al redimensionar se llama a fd.setTableSize, así que fd no
+// debería compartirse con otra tabla.
+//
+// Con setIncrementalRehash(n), n > 0, el crecimiento automático no reinserta todo
+// de golpe: la tabla nueva sustituye a la actual, que se conserva como tabla
+// antigua, y cada inserción o búsqueda posterior traslada n celdas de la antigua
+// a la nueva. Mientras dura el traslado las búsquedas miran en ambas tablas.
+//
+// Si fe.robinHood() (RobinHoodExploration) las claves se insertan con la política
+// Robin Hood: cada hueco guarda la distancia de su clave a su celda inicial y una
+// clave que llega a una celda llena desplaza a la más rica (la de menor distancia)
+// si está más lejos de su inicio que ella. Cada celda recuerda la mayor distancia
+// que ha guardado (maxDistance, que no baja al borrar): una búsqueda que llega a
+// una celda con maxDistance menor que su propia distancia allí puede parar, porque
+// al pasar por esa celda la clave habría desplazado a alguna.
+//
+// erase deja una lápida en la celda de la clave (ver staticSequence), así que las
+// cadenas de exploración no se acortan al borrar. Cuando las lápidas superan la
+// fracción setMaxTombstoneRatio de los huecos la tabla se compacta reinsertando
+// las claves, y tombstoneRatio() permite decidir cuándo hacerlo a mano (compact).
+template<class Key, class Container = staticSequence<Key>,
+         class Fd = DispersionFunction<Key>, class Fe = ExplorationFunction<Key> >
+class HashTable : public Sequence<Key> {
+private:
+    unsigned tableSize;
+    unsigned blockSize;
+    // mutable: también las búsquedas avanzan el traslado incremental.
+    mutable BucketStorage<Key, Container> table;
+    Fd& fd;
+    Fe& fe;
+    bool robinHood;        // fe.robinHood()
+    unsigned long count;   // Número de claves almacenadas
+    double maxLoadFactor;  // 0: sin redimensionado automático
+    unsigned rehashStep;   // Celdas trasladadas por operación (0: todo de golpe)
+    mutable unsigned long tombstones; // Lápidas en table
+    double maxTombstoneRatio;         // 0: sin compactación automática
+    mutable BucketStorage<Key, Container> oldTable; // Tabla antigua durante el traslado
+    mutable unsigned oldSize;                       // Sus celdas (0: no hay traslado)
+    mutable unsigned migrated;                      // Celdas ya trasladadas
+    mutable bool stalled;                           // Traslado detenido (ver migrate)
+    mutable ProbeStats stats;
+    mutable TableStats counters;
+
+    // Inserta key en storage (de ts celdas) sin comprobar el factor de carga.
+    // Solo table puede tener lápidas (las tablas nuevas empiezan sin ellas), así
+    // que si la celda elegida las tenía la inserción ha reutilizado una de table.
+    bool insertInto(BucketStorage<Key, Container> &storage, unsigned ts, const Key &key) const {
+        if(robinHood) {
+            unsigned length = robinHoodInsert(storage, ts, key);
+            stats.record(length ? length : ts);
+            return length != 0;
+        }
+        ProbeSequence<Key> probe = fe.probe(key, fd.hash(key, ts), ts);
+        unsigned maxAttempts = ts;
+        for(unsigned i = 0; i < maxAttempts; i++, probe.next()){
+            auto &&cell = storage[probe.position()];
+            bool reused = cell.wasFull();
+            if(cell.insert(key)) {
+                if(reused) tombstones--;
+                stats.record(i + 1);
                 return true;
+            }
         }
+        stats.record(maxAttempts);
         return false;
     }
-    bool insert(const Key &key) override {
-        unsigned h = fd(key);
+    // Inserción Robin Hood (key no está en storage). La clave que se coloca viaja
+    // con su distancia; en cada celda llena, si la clave más rica de la celda
+    // tiene menor distancia se intercambian y sigue la desplazada. Como la
+    // exploración es lineal, la desplazada continúa por la misma secuencia.
+    // Devuelve las celdas visitadas, o 0 si no hay hueco en ts celdas: entonces
+    // se habría perdido una clave desplazada, así que quien llama debe asegurar
+    // que storage tiene algún hueco libre.
+    unsigned robinHoodInsert(BucketStorage<Key, Container> &storage, unsigned ts, const Key &newKey) const {
+        Key key = newKey;
+        unsigned distance = 0;
+        ProbeSequence<Key> probe = fe.probe(key, fd.hash(key, ts), ts);
+        for(unsigned length = 1; length <= ts; length++, distance++, probe.next()) {
+            auto &&cell = storage[probe.position()];
+            bool reused = cell.wasFull();
+            if(cell.insert(key, distance)) {
+                if(reused) tombstones--;
+                return length;
+            }
+            unsigned richest = cell.richest();
+            if(cell.distance(richest) < distance)
+                cell.exchange(richest, key, distance);
+        }
+        return 0;
+    }
+    unsigned long capacity(unsigned ts) const {
+        return static_cast<unsigned long>(ts) * blockSize;
+    }
+    // Robin Hood: key no puede estar en pos ni más adelante si la celda nunca ha
+    // guardado una clave tan lejos de su inicio como lo estaría key allí (attempt).
+    bool beyondReach(unsigned pos, unsigned attempt) const {
+        return robinHood && table[pos].maxDistance() < attempt;
+    }
+    // Traslada hasta n celdas de la tabla antigua a la nueva; con el traslado
+    // completo libera la antigua. Las reinserciones no cuentan en las estadísticas.
+    // Una celda trasladada se libera con vacate, que conserva si contaba como
+    // llena, así que las cadenas de exploración de la tabla antigua terminan donde
+    // terminaban (ver locateOld) y la tabla antigua se destruye poco a poco.
+    // Si alguna clave no cabe en la tabla nueva, el traslado se detiene (stalled)
+    // y la siguiente inserción hará un rehash completo. Las claves que sí se han
+    // trasladado se borran de la celda antigua, que conserva las que no caben y
+    // sigue contando como llena si lo estaba.
+    void migrate(unsigned n) const {
+        if(oldSize == 0 || stalled) return;
+        ProbeStats saved = stats;
+        for(; n > 0 && migrated < oldSize; n--, migrated++) {
+            const BucketStorage<Key, Container> &old = oldTable; // Sin construir celdas
+            std::vector<Key> failed;
+            old[migrated].forEach([&](const Key &key) {
+                if(!insertInto(table, tableSize, key)) failed.push_back(key);
+            });
+            if(failed.empty()) {
+                oldTable.vacate(migrated);
+                continue;
+            }
+            auto &&cell = oldTable[migrated];
+            std::vector<Key> moved;
+            cell.forEach([&](const Key &key) {
+                if(std::find(failed.begin(), failed.end(), key) == failed.end()) moved.push_back(key);
+            });
+            for(const Key &key : moved) cell.erase(key);
+            stalled = true;
+            break;
+        }
+        stats = saved;
+        if(migrated == oldSize)
+            dropOldTable();
+    }
+    void dropOldTable() const {
+        BucketStorage<Key, Container> empty(0, blockSize);
+        oldTable.swap(empty);
+        oldSize = 0;
+        migrated = 0;
+        stalled = false;
+    }
+    // La búsqueda sigue la misma secuencia de exploración que insert, que coloca
+    // la clave en la primera celda no llena: si la clave no está en una celda que
+    // nunca se ha llenado (sin contar lápidas), tampoco puede estar más adelante y
+    // se termina ahí. Así un fallo cuesta lo que la cadena de exploración, no
+    // tableSize celdas. K es Key o NumericKey.
+    template<class K>
+    Key* locate(const K &key) const { return locate(key, fd.hash(key, tableSize)); }
+    // Lo mismo con la celda inicial h ya calculada (el traslado no cambia tableSize).
+    template<class K>
+    Key* locate(const K &key, unsigned h) const {
+        migrate(rehashStep);
+        ProbeSequence<Key> probe = fe.probe(key, h, tableSize);
         unsigned maxAttempts = tableSize;
-        for(unsigned i = 0; i < maxAttempts; i++){
-            unsigned pos = (h + fe(key, i)) % tableSize;
-            if(table[pos]->insert(key))
-                return true;
+        for(unsigned i = 0; i < maxAttempts; i++, probe.next()){
+            unsigned pos = probe.position();
+            if(!beyondReach(pos, i)) {
+                if(Key *found = table[pos].find(key)) {
+                    stats.record(i + 1);
+                    return found;
+                }
+            }
+            if(!table[pos].wasFull() || beyondReach(pos, i)) {
+                stats.record(i + 1);
+                return oldSize != 0 ? locateOld(key) : nullptr;
+            }
+        }
+        stats.record(maxAttempts);
+        return oldSize != 0 ? locateOld(key) : nullptr;
+    }
+    // Búsqueda en la tabla antigua durante el traslado. Las celdas ya trasladadas
+    // están vacías, pero las que se habían llenado siguen contando como llenas
+    // (ver migrate), así que la exploración para donde paraba antes del traslado.
+    template<class K>
+    Key* locateOld(const K &key) const {
+        ProbeSequence<Key> probe = fe.probe(key, fd.hash(key, oldSize), oldSize);
+        for(unsigned i = 0; i < oldSize; i++, probe.next()){
+            unsigned pos = probe.position();
+            if(Key *found = oldTable[pos].find(key)) return found;
+            if(!oldTable[pos].wasFull()) return nullptr;
+        }
+        return nullptr;
+    }
+    // Borrado en la tabla antigua durante el traslado; la lápida queda en la
+    // celda antigua y desaparece al trasladarla.
+    bool eraseOld(const Key &key) {
+        ProbeSequence<Key> probe = fe.probe(key, fd.hash(key, oldSize), oldSize);
+        for(unsigned i = 0; i < oldSize; i++, probe.next()){
+            unsigned pos = probe.position();
+            if(oldTable[pos].erase(key)) return true;
+            if(!oldTable[pos].wasFull()) return false;
         }
         return false;
     }
+    // Inserción sin repetidos en una sola pasada por la cadena de exploración:
+    // se busca key hasta el final de la cadena (la primera celda que nunca se ha
+    // llenado) recordando la primera celda con hueco, que puede ser anterior si
+    // tiene lápidas. Si key ya estaba devuelve PRESENT y su hueco en found.
+    // Con place = false, o si la cadena no tiene hueco, devuelve NO_ROOM sin
+    // insertar (key no está en la tabla). h es la celda inicial de key.
+    InsertResult probeInsert(const Key &key, unsigned h, bool place, Key *&found) {
+        ProbeSequence<Key> probe = fe.probe(key, h, tableSize);
+        unsigned target = tableSize; // Primera celda con hueco (tableSize: ninguna)
+        unsigned length = 0;
+        found = nullptr;
+        while(length < tableSize) {
+            unsigned pos = probe.position();
+            if(beyondReach(pos, length)) {
+                length++;
+                break;
+            }
+            length++;
+            if((found = table[pos].find(key)) != nullptr) break;
+            if(target == tableSize && !table[pos].isFull()) target = pos;
+            if(!table[pos].wasFull()) break;
+            probe.next();
+        }
+        if(found == nullptr && oldSize != 0) found = locateOld(key);
+        if(found != nullptr || !place || (robinHood && count >= capacity(tableSize))) {
+            stats.record(length);
+            return found != nullptr ? PRESENT : NO_ROOM;
+        }
+        if(robinHood) {
+            // La posición la decide el desplazamiento, no la primera celda con hueco.
+            unsigned placed = robinHoodInsert(table, tableSize, key);
+            stats.record(placed > length ? placed : length);
+            count++;
+            return INSERTED;
+        }
+        stats.record(length);
+        if(target == tableSize) return NO_ROOM;
+        auto &&cell = table[target];
+        if(cell.wasFull()) tombstones--; // Reutiliza una lápida
+        cell.insert(key);
+        count++;
+        return INSERTED;
+    }
+    // Insertar sin repetidos. Si key es nueva pero hay que crecer (o su cadena no
+    // tiene hueco) se inserta en la tabla redimensionada, donde no hace falta
+    // volver a buscarla. h es fd.hash(key, hashedSize); si la tabla ya no tiene
+    // hashedSize celdas (0: sin calcular) se calcula de nuevo.
+    InsertResult insertOrFind(const Key &key, Key *&found, unsigned h = 0, unsigned hashedSize = 0) {
+        if(stalled) grow();
+        migrate(rehashStep);
+        bool fits = maxLoadFactor <= 0 || count + 1 <= maxLoadFactor * capacity(tableSize);
+        if(hashedSize != tableSize) h = fd.hash(key, tableSize);
+        InsertResult result = probeInsert(key, h, fits, found);
+        if(result != NO_ROOM) return result;
+        if(!fits) grow();
+        // Robin Hood no puede intentar insertar en una tabla llena (ver robinHoodInsert).
+        while((robinHood && count >= capacity(tableSize)) || !insertInto(table, tableSize, key)) {
+            // Sin hueco: se crece de golpe.
+            if(maxLoadFactor <= 0 || !rehash(nextPrime(2 * tableSize + 1))) return NO_ROOM;
+        }
+        count++;
+        return INSERTED;
+    }
+    // Inserción de bulk_load dentro de las celdas [lo, hi), que solo toca un hilo.
+    // Como probeInsert, pero devuelve NO_ROOM si la cadena sale del rango antes
+    // de terminar o no tiene hueco: la clave se insertará después fuera de la
+    // carga paralela. reused cuenta las lápidas reutilizadas.
+    InsertResult bulkPlace(const Key &key, unsigned home, unsigned lo, unsigned hi,
+                           unsigned long &reused) {
+        ProbeSequence<Key> probe = fe.probe(key, home, tableSize);
+        unsigned target = tableSize;
+        for(unsigned i = 0; i < tableSize; i++, probe.next()) {
+            unsigned pos = probe.position();
+            if(pos < lo || pos >= hi) return NO_ROOM;
+            if(table[pos].find(key)) return PRESENT;
+            if(target == tableSize && !table[pos].isFull()) target = pos;
+            if(!table[pos].wasFull()) break;
+        }
+        if(target == tableSize) return NO_ROOM;
+        auto &&cell = table[target];
+        if(cell.wasFull()) reused++;
+        cell.insert(key);
+        return INSERTED;
+    }
+    // Anota en counters la inserción que acaba de hacer insertOrFind: hay
+    // colisión si la clave nueva no ha quedado en la primera celda visitada.
+    InsertResult counted(InsertResult result) const {
+        counters.recordInsert(stats.last, result == INSERTED && stats.last > 1);
+        return result;
+    }
+    // Crecimiento automático: de golpe o iniciando un traslado incremental.
+    // Si aún hay un traslado en curso se hace de golpe.
+    bool grow() {
+        unsigned newSize = nextPrime(2 * tableSize + 1);
+        if(rehashStep == 0 || oldSize != 0) return rehash(newSize);
+        BucketStorage<Key, Container> newTable(newSize, blockSize);
+        oldTable.swap(table);
+        table.swap(newTable);
+        oldSize = tableSize;
+        migrated = 0;
+        tombstones = 0;
+        tableSize = newSize;
+        fd.setTableSize(newSize);
+        return true;
+    }
+public:
+    HashTable(unsigned ts, Fd& dispFunc, Fe& explFunc, unsigned bs)
+    : tableSize(ts), blockSize(bs), table(ts, bs), fd(dispFunc), fe(explFunc),
+      robinHood(explFunc.robinHood()), count(0), maxLoadFactor(0), rehashStep(0), tombstones(0), maxTombstoneRatio(0.25),
+      oldTable(0, bs), oldSize(0), migrated(0), stalled(false) {}
+    bool search(const Key &key) const override { return find(key) != nullptr; }
+    // Clave guardada que coincide con key, o nullptr. Con una NumericKey
+    // (p. ej. persona::idKey(id)) se busca sin construir una clave completa.
+    // El puntero deja de ser válido al insertar, borrar o redimensionar y,
+    // durante un traslado incremental (isRehashing()), también con la siguiente
+    // búsqueda: find y search trasladan celdas y pueden mover la clave.
+    template<class K>
+    const Key* find(const K &key) const {
+        const Key *found = locate(key);
+        counters.recordSearch(stats.last, found != nullptr);
+        return found;
+    }
+    // Inserta key si no estaba. Devuelve false si ya estaba o no cabe.
+    bool insert(const Key &key) override { return insertUnique(key) == INSERTED; }
+    // Como insert, pero distingue una clave repetida de una que no cabe.
+    InsertResult insertUnique(const Key &key) {
+        Key *found;
+        return counted(insertOrFind(key, found));
+    }
+    // Sustituye la clave igual a key por key, o la inserta si no estaba.
+    // Devuelve true si se ha insertado.
+    bool insert_or_assign(const Key &key) {
+        Key *found;
+        InsertResult result = counted(insertOrFind(key, found));
+        if(result == PRESENT) *found = key;
+        return result == INSERTED;
+    }
+    // Construye la clave con args y la inserta si no estaba.
+    // Devuelve true si se ha insertado.
+    template<class... Args>
+    bool emplace(Args&&... args) {
+        return insert(Key(std::forward<Args>(args)...));
+    }
+    // Búsqueda por lotes: results[i] indica si keys[i] (Key o NumericKey) está en
+    // la tabla; devuelve cuántas se han encontrado. Las claves se procesan en
+    // grupos de batchWindow: se calculan las celdas iniciales del grupo y se
+    // piden a caché (prefetch) antes de resolver sus búsquedas, de modo que las
+    // esperas a memoria de búsquedas independientes se solapan.
+    template<class K>
+    unsigned long search_batch(const std::vector<K> &keys, std::vector<bool> &results) const {
+        results.assign(keys.size(), false);
+        unsigned long hits = 0;
+        unsigned homes[batchWindow];
+        for(size_t base = 0; base < keys.size(); base += batchWindow) {
+            size_t n = std::min<size_t>(batchWindow, keys.size() - base);
+            for(size_t j = 0; j < n; j++) {
+                homes[j] = fd.hash(keys[base + j], tableSize);
+                table.prefetch(homes[j]);
+            }
+            for(size_t j = 0; j < n; j++) {
+                bool found = locate(keys[base + j], homes[j]) != nullptr;
+                counters.recordSearch(stats.last, found);
+                if(found) {
+                    results[base + j] = true;
+                    hits++;
+                }
+            }
+        }
+        return hits;
+    }
+    // Inserción por lotes, sin repetidos, con el mismo esquema que search_batch.
+    // Devuelve cuántas claves eran nuevas. Si la tabla crece a mitad de un grupo
+    // las celdas iniciales que quedan se recalculan.
+    unsigned long insert_batch(const std::vector<Key> &keys) {
+        unsigned long inserted = 0;
+        unsigned homes[batchWindow];
+        for(size_t base = 0; base < keys.size(); base += batchWindow) {
+            size_t n = std::min<size_t>(batchWindow, keys.size() - base);
+            unsigned ts = tableSize;
+            for(size_t j = 0; j < n; j++) {
+                homes[j] = fd.hash(keys[base + j], ts);
+                table.prefetch(homes[j]);
+            }
+            for(size_t j = 0; j < n; j++) {
+                Key *found;
+                if(counted(insertOrFind(keys[base + j], found, homes[j], ts)) == INSERTED) inserted++;
+            }
+        }
+        return inserted;
+    }
+    // Carga masiva: inserta sin repetidos las claves de [first, last) (iteradores
+    // de acceso aleatorio) con threads hilos (0: los del procesador) y devuelve
+    // cuántas eran nuevas. Antes se completa el traslado pendiente y, con
+    // redimensionado automático, la tabla crece de una vez para todas (contando
+    // las repetidas). Las celdas iniciales se calculan en paralelo, las claves se
+    // agrupan por rangos de celdas (partitionKeys) y cada hilo llena sus rangos
+    // en el orden de la entrada. Una clave cuya cadena sale de su rango antes de
+    // encontrar hueco se aparta y se inserta al final con insertUnique. Como cada
+    // rango es de un solo hilo y las celdas solo se llenan, cada clave queda en
+    // su cadena tras celdas llenas, igual que con inserciones sucesivas.
+    // Los rangos pares se llenan antes que los impares: la búsqueda de huellas
+    // de 16 en 16 (findTag) puede leer las primeras del rango siguiente.
+    // Con Robin Hood las claves se insertan una a una. No cuenta en probeStats
+    // ni en statistics.
+    template<class It>
+    unsigned long bulk_load(It first, It last, unsigned threads = 0) {
+        size_t n = last - first;
+        unsigned long before = count;
+        ProbeStats saved = stats;
+        if(oldSize != 0 && !rehash(tableSize)) grow();
+        if(maxLoadFactor > 0) {
+            unsigned newSize = tableSize;
+            while(count + n > maxLoadFactor * capacity(newSize))
+                newSize = nextPrime(2 * newSize + 1);
+            if(newSize != tableSize) rehash(newSize);
+        }
+        Key *found;
+        if(robinHood) {
+            for(It it = first; it != last; ++it) insertOrFind(*it, found);
+            stats = saved;
+            return count - before;
+        }
+        threads = bulkThreads(threads);
+        BulkPartition part;
+        partitionKeys(n, tableSize, std::max(1u, std::min(threads * 8, tableSize / 16)), threads,
+                      [&](size_t i) { return fd.hash(first[i], tableSize); }, part);
+        std::vector<std::vector<size_t> > deferred(threads);
+        std::vector<unsigned long> placed(threads, 0), reused(threads, 0);
+        for(unsigned parity = 0; parity < 2; parity++) {
+            runParallel(threads, [&](unsigned t) {
+                unsigned long added = 0, tombs = 0;
+                for(unsigned p = 2 * t + parity; p < part.partitions; p += 2 * threads) {
+                    unsigned lo = part.begin(p), hi = part.end(p, tableSize);
+                    for(size_t k = part.start[p]; k < part.start[p + 1]; k++) {
+                        size_t i = part.order[k];
+                        InsertResult result = bulkPlace(first[i], part.home[i], lo, hi, tombs);
+                        if(result == INSERTED) added++;
+                        else if(result == NO_ROOM) deferred[t].push_back(i);
+                    }
+                }
+                placed[t] += added;
+                reused[t] += tombs;
+            });
+        }
+        for(unsigned t = 0; t < threads; t++) {
+            count += placed[t];
+            tombstones -= reused[t];
+        }
+        for(unsigned t = 0; t < threads; t++)
+            for(size_t i : deferred[t]) insertOrFind(first[i], found);
+        stats = saved;
+        return count - before;
+    }
+    // Elimina key dejando una lápida si su celda se había llenado (ver
+    // staticSequence). Compacta si las lápidas superan el máximo.
+    bool erase(const Key &key) override {
+        counters.recordErase();
+        migrate(rehashStep);
+        ProbeSequence<Key> probe = fe.probe(key, fd.hash(key, tableSize), tableSize);
+        bool erased = false;
+        for(unsigned i = 0; i < tableSize && !erased; i++, probe.next()){
+            unsigned pos = probe.position();
+            if(beyondReach(pos, i)) break;
+            auto &&cell = table[pos];
+            bool full = cell.wasFull(); // Solo una celda llena deja lápida
+            erased = cell.erase(key);
+            if(erased && full) tombstones++;
+            else if(!erased && !full) break;
+        }
+        if(!erased && !(oldSize != 0 && eraseOld(key))) return false;
+        count--;
+        if(maxTombstoneRatio > 0 && tombstoneRatio() > maxTombstoneRatio)
+            compact();
+        return true;
+    }
+    // Reinserta las claves en una tabla del mismo tamaño sin lápidas.
+    bool compact() { return rehash(tableSize); }
+    // Reconstruye la tabla con newSize celdas reinsertando todas las claves,
+    // incluidas las que quedaran en la tabla antigua de un traslado incremental.
+    // Devuelve false (y deja la tabla como estaba) si no caben.
+    bool rehash(unsigned newSize) {
+        if(newSize == 0 || capacity(newSize) < count) return false;
+        BucketStorage<Key, Container> newTable(newSize, blockSize);
+        ProbeStats saved = stats; // Las reinserciones no cuentan como operaciones
+        bool ok = true;
+        auto reinsert = [&](const Key &key) {
+            if(ok) ok = insertInto(newTable, newSize, key);
+        };
+        // Con referencias const no se construyen las celdas que no se han usado.
+        const BucketStorage<Key, Container> &current = table, &old = oldTable;
+        for(unsigned pos = 0; pos < tableSize && ok; pos++)
+            current[pos].forEach(reinsert);
+        for(unsigned pos = migrated; pos < oldSize && ok; pos++)
+            old[pos].forEach(reinsert);
+        stats = saved;
+        if(!ok) return false;
+        table.swap(newTable);
+        dropOldTable();
+        tombstones = 0;
+        tableSize = newSize;
+        fd.setTableSize(newSize);
+        return true;
+    }
+    // Factor de carga máximo antes de crecer (0 desactiva el redimensionado automático).
+    void setMaxLoadFactor(double f) { maxLoadFactor = f; }
+    double getMaxLoadFactor() const { return maxLoadFactor; }
+    // Celdas trasladadas por operación al crecer (0: reinserción completa de golpe).
+    // Al pasar a 0 se completa el traslado pendiente.
+    void setIncrementalRehash(unsigned step) {
+        rehashStep = step;
+        if(step == 0 && oldSize != 0) rehash(tableSize);
+    }
+    bool isRehashing() const { return oldSize != 0; }
+    // Fracción de lápidas (sobre tableSize * blockSize huecos) que dispara la
+    // compactación tras un borrado (0 la desactiva).
+    void setMaxTombstoneRatio(double r) { maxTombstoneRatio = r; }
+    double getMaxTombstoneRatio() const { return maxTombstoneRatio; }
+    double tombstoneRatio() const { return static_cast<double>(tombstones) / capacity(tableSize); }
+    double loadFactor() const { return static_cast<double>(count) / capacity(tableSize); }
+    unsigned long size() const { return count; }
+    unsigned getTableSize() const { return tableSize; }
+    // Estadísticas de exploración acumuladas desde la creación o el último reset
+    // (solo con HASH_STATS).
+    const ProbeStats& probeStats() const { return stats; }
+    void resetProbeStats() { stats = ProbeStats(); }
+    // Contadores de uso (vacíos salvo con HASH_STATS, ver TableStats).
+    const TableStats& statistics() const { return counters; }
+    void resetStatistics() { counters = TableStats(); }
+    // Número de celdas con 0, 1, 2, ... claves (sin la tabla antigua de un traslado).
+    std::vector<unsigned long> occupancy() const { return occupancyHistogram(table, tableSize); }
 };
 
-// Especialización parcial para dispersión abierta (usa dynamicSequence)
+// Dispersión abierta con celdas de tipo Chain (dynamicSequence o inlineSequence).
+// Las celdas se guardan por valor en un ChainStorage. HashTable la usa a través de las
+// especializaciones parciales de más abajo.
 // No se usan función de exploración ni blockSize.
-template<class Key>
-class HashTable<Key, dynamicSequence<Key> > : public Sequence<Key> {
+// Con setMaxLoadFactor(f), f > 0, cuando el número medio de claves por celda
+// superaría f la tabla pasa a tener el primo >= 2 * tableSize + 1 celdas y
+// reparte de nuevo las claves, de modo que las listas no crecen sin límite.
+// Con setIncrementalRehash(n) el reparto se hace poco a poco, n celdas por
+// inserción o búsqueda, igual que en la dispersión cerrada: la tabla nueva se
+// construye celda a celda según se usa y la antigua se destruye según se traslada.
+template<class Key, class Chain, class Fd>
+class OpenHashTable : public Sequence<Key> {
+private:
+    typedef ChainStorage<Chain> Buckets;
+    unsigned tableSize;
+    mutable Buckets table;
+    Fd& fd;
+    unsigned long count;
+    double maxLoadFactor;
+    unsigned rehashStep;
+    mutable Buckets oldTable;   // Tabla antigua durante el traslado (vacía si no hay)
+    mutable unsigned migrated;  // Celdas de oldTable ya trasladadas
+    mutable TableStats counters; // Cada operación visita una celda; colisión: cadena no vacía
+
+    static void release(Buckets &buckets) { Buckets().swap(buckets); }
+    unsigned oldSize() const { return static_cast<unsigned>(oldTable.size()); }
+    void migrate(unsigned n) const {
+        if(oldTable.empty()) return;
+        const Buckets &old = oldTable; // Sin construir celdas
+        for(; n > 0 && migrated < oldSize(); n--, migrated++) {
+            old[migrated].forEach([&](const Key &key) {
+                table[fd.hash(key, tableSize)].insert(key);
+            });
+            oldTable.vacate(migrated);
+        }
+        if(migrated == oldSize())
+            release(oldTable);
+    }
+    void finishMigration() const { migrate(oldSize()); }
+    template<class K>
+    Key* locate(const K &key) const {
+        migrate(rehashStep);
+        return locateIn(key, fd.hash(key, tableSize));
+    }
+    // Busca key en la celda pos de la tabla y, durante el traslado, en la antigua.
+    template<class K>
+    Key* locateIn(const K &key, unsigned pos) const {
+        if(Key *found = table[pos].find(key)) return found;
+        if(oldTable.empty()) return nullptr;
+        unsigned oldPos = fd.hash(key, oldSize());
+        return oldPos >= migrated ? oldTable[oldPos].find(key) : nullptr;
+    }
+    // Inserción sin repetidos: la celda de key se calcula una vez para buscar e
+    // insertar (salvo que la tabla crezca entre medias). pos es fd.hash(key,
+    // hashedSize), que se recalcula si la tabla no tiene hashedSize celdas.
+    InsertResult insertOrFind(const Key &key, Key *&found, unsigned pos = 0, unsigned hashedSize = 0) {
+        migrate(rehashStep);
+        if(hashedSize != tableSize) pos = fd.hash(key, tableSize);
+        if((found = locateIn(key, pos)) != nullptr) {
+            counters.recordInsert(1, false);
+            return PRESENT;
+        }
+        if(maxLoadFactor > 0 && count + 1 > maxLoadFactor * tableSize) {
+            grow();
+            pos = fd.hash(key, tableSize);
+        }
+        counters.recordInsert(1, table[pos].size() != 0);
+        if(!table[pos].insert(key)) return NO_ROOM;
+        count++;
+        return INSERTED;
+    }
+    void grow() {
+        unsigned newSize = nextPrime(2 * tableSize + 1);
+        if(rehashStep == 0) {
+            rehash(newSize);
+            return;
+        }
+        finishMigration();
+        Buckets newTable(newSize);
+        oldTable.swap(table);
+        table.swap(newTable);
+        migrated = 0;
+        tableSize = newSize;
+        fd.setTableSize(newSize);
+    }
+public:
+    OpenHashTable(unsigned ts, Fd& dispFunc)
+    : tableSize(ts), table(ts), fd(dispFunc), count(0), maxLoadFactor(0), rehashStep(0),
+      migrated(0) {}
+    bool search(const Key &key) const override { return find(key) != nullptr; }
+    // Igual que en la dispersión cerrada: K es Key o NumericKey, y durante un
+    // traslado incremental el puntero solo vale hasta la siguiente búsqueda.
+    template<class K>
+    const Key* find(const K &key) const {
+        const Key *found = locate(key);
+        counters.recordSearch(1, found != nullptr);
+        return found;
+    }
+    bool insert(const Key &key) override { return insertUnique(key) == INSERTED; }
+    InsertResult insertUnique(const Key &key) {
+        Key *found;
+        return insertOrFind(key, found);
+    }
+    bool insert_or_assign(const Key &key) {
+        Key *found;
+        InsertResult result = insertOrFind(key, found);
+        if(result == PRESENT) *found = key;
+        return result == INSERTED;
+    }
+    template<class... Args>
+    bool emplace(Args&&... args) {
+        return insert(Key(std::forward<Args>(args)...));
+    }
+    // Búsqueda e inserción por lotes como en la dispersión cerrada; se pide a
+    // caché la celda (con inlineSequence, sus primeras claves y huellas).
+    template<class K>
+    unsigned long search_batch(const std::vector<K> &keys, std::vector<bool> &results) const {
+        results.assign(keys.size(), false);
+        unsigned long hits = 0;
+        unsigned homes[batchWindow];
+        for(size_t base = 0; base < keys.size(); base += batchWindow) {
+            size_t n = std::min<size_t>(batchWindow, keys.size() - base);
+            for(size_t j = 0; j < n; j++) {
+                homes[j] = fd.hash(keys[base + j], tableSize);
+                table.prefetch(homes[j]);
+            }
+            for(size_t j = 0; j < n; j++) {
+                migrate(rehashStep);
+                bool found = locateIn(keys[base + j], homes[j]) != nullptr;
+                counters.recordSearch(1, found);
+                if(found) {
+                    results[base + j] = true;
+                    hits++;
+                }
+            }
+        }
+        return hits;
+    }
+    unsigned long insert_batch(const std::vector<Key> &keys) {
+        unsigned long inserted = 0;
+        unsigned homes[batchWindow];
+        for(size_t base = 0; base < keys.size(); base += batchWindow) {
+            size_t n = std::min<size_t>(batchWindow, keys.size() - base);
+            unsigned ts = tableSize;
+            for(size_t j = 0; j < n; j++) {
+                homes[j] = fd.hash(keys[base + j], ts);
+                table.prefetch(homes[j]);
+            }
+            for(size_t j = 0; j < n; j++) {
+                Key *found;
+                if(insertOrFind(keys[base + j], found, homes[j], ts) == INSERTED) inserted++;
+            }
+        }
+        return inserted;
+    }
+    // Carga masiva como en la dispersión cerrada: cada hilo añade a las cadenas
+    // de sus rangos de celdas las claves que les tocan. Aquí ninguna clave sale
+    // de su celda, así que no se aparta ninguna para el final.
+    template<class It>
+    unsigned long bulk_load(It first, It last, unsigned threads = 0) {
+        size_t n = last - first;
+        finishMigration();
+        if(maxLoadFactor > 0) {
+            unsigned newSize = tableSize;
+            while(count + n > maxLoadFactor * newSize)
+                newSize = nextPrime(2 * newSize + 1);
+            if(newSize != tableSize) rehash(newSize);
+        }
+        threads = bulkThreads(threads);
+        BulkPartition part;
+        partitionKeys(n, tableSize, std::max(1u, std::min(threads * 8, tableSize)), threads,
+                      [&](size_t i) { return fd.hash(first[i], tableSize); }, part);
+        std::vector<unsigned long> placed(threads, 0);
+        runParallel(threads, [&](unsigned t) {
+            unsigned long added = 0;
+            for(unsigned p = t; p < part.partitions; p += threads) {
+                for(size_t k = part.start[p]; k < part.start[p + 1]; k++) {
+                    size_t i = part.order[k];
+                    Chain &chain = table[part.home[i]];
+                    if(!chain.find(first[i]) && chain.insert(first[i])) added++;
+                }
+            }
+            placed[t] = added;
+        });
+        unsigned long before = count;
+        for(unsigned t = 0; t < threads; t++) count += placed[t];
+        return count - before;
+    }
+    bool erase(const Key &key) override {
+        counters.recordErase();
+        migrate(rehashStep);
+        bool erased = table[fd.hash(key, tableSize)].erase(key);
+        if(!erased && !oldTable.empty()) {
+            unsigned oldPos = fd.hash(key, oldSize());
+            erased = oldPos >= migrated && oldTable[oldPos].erase(key);
+        }
+        if(erased) count--;
+        return erased;
+    }
+    // Reparte todas las claves en una tabla de newSize celdas.
+    bool rehash(unsigned newSize) {
+        if(newSize == 0) return false;
+        finishMigration();
+        Buckets newTable(newSize);
+        const Buckets &current = table; // Sin construir celdas
+        for(unsigned pos = 0; pos < tableSize; pos++) {
+            current[pos].forEach([&](const Key &key) {
+                newTable[fd.hash(key, newSize)].insert(key);
+            });
+        }
+        table.swap(newTable);
+        tableSize = newSize;
+        fd.setTableSize(newSize);
+        return true;
+    }
+    void setMaxLoadFactor(double f) { maxLoadFactor = f; }
+    double getMaxLoadFactor() const { return maxLoadFactor; }
+    void setIncrementalRehash(unsigned step) {
+        rehashStep = step;
+        if(step == 0) finishMigration();
+    }
+    bool isRehashing() const { return !oldTable.empty(); }
+    // Las cadenas se borran sin dejar lápidas.
+    double tombstoneRatio() const { return 0.0; }
+    double loadFactor() const { return static_cast<double>(count) / tableSize; }
+    unsigned long size() const { return count; }
+    unsigned getTableSize() const { return tableSize; }
+    const TableStats& statistics() const { return counters; }
+    void resetStatistics() { counters = TableStats(); }
+    // Número de celdas cuya cadena tiene 0, 1, 2, ... claves.
+    std::vector<unsigned long> occupancy() const { return occupancyHistogram(table, tableSize); }
+};
+
+// Especialización parcial para dispersión abierta con listas (dynamicSequence).
+template<class Key, class Fd, class Fe>
+class HashTable<Key, dynamicSequence<Key>, Fd, Fe> : public OpenHashTable<Key, dynamicSequence<Key>, Fd> {
+public:
+    HashTable(unsigned ts, Fd& dispFunc) : OpenHashTable<Key, dynamicSequence<Key>, Fd>(ts, dispFunc) {}
+};
+
+// Especialización parcial para dispersión abierta con vectores pequeños en línea
+// (inlineSequence): las claves de una cadena corta están en el propio vector de celdas.
+template<class Key, unsigned N, class Fd, class Fe>
+class HashTable<Key, inlineSequence<Key, N>, Fd, Fe> : public OpenHashTable<Key, inlineSequence<Key, N>, Fd> {
+public:
+    HashTable(unsigned ts, Fd& dispFunc) : OpenHashTable<Key, inlineSequence<Key, N>, Fd>(ts, dispFunc) {}
+};
+
+// Dispersión cuckoo: cada clave solo puede estar en una de dos celdas de blockSize
+// huecos, la de fd y la de una segunda función alt (MixHashFunction, propiedad de
+// la tabla), o en un pequeño almacén auxiliar (stash) de como mucho stashSize
+// claves. Una búsqueda mira como máximo esas dos celdas y el stash, así que su
+// coste en el peor caso está acotado: 2 * blockSize + stashSize comparaciones de
+// huella o clave, sin exploración. Las celdas son Container (flatSequence o
+// staticSequence) con el mismo almacenamiento que la dispersión cerrada.
+//
+// Al insertar, si las dos celdas están llenas la clave expulsa a otra de una de
+// ellas, que pasa a su otra celda, y así sucesivamente hasta maxKicks expulsiones.
+// Si no acaba (hay un ciclo) las expulsiones se deshacen y la clave va al stash;
+// con el stash lleno se reconstruye la tabla con una nueva semilla para alt (hasta
+// maxReseeds intentos) y, si no basta y hay redimensionado automático, con más
+// celdas. Sin redimensionado automático la inserción devuelve NO_ROOM.
+//
+// setMaxLoadFactor(f), f > 0, hace crecer la tabla como en la dispersión cerrada.
+// No hay traslado incremental. erase quita la clave sin dejar lápida, porque
+// ninguna búsqueda depende de haber pasado por una celda llena.
+template<class Key, class Container = flatSequence<Key>, class Fd = DispersionFunction<Key> >
+class CuckooHashTable : public Sequence<Key> {
 private:
+    static const unsigned maxKicks = 500;
+    static const unsigned maxReseeds = 8;
+    static const unsigned stashSize = 4;
     unsigned tableSize;
-    std::vector<dynamicSequence<Key>*> table;
-    DispersionFunction<Key>& fd;
+    unsigned blockSize;
+    BucketStorage<Key, Container> table;
+    Fd& fd;
+    MixHashFunction<Key> alt;
+    std::vector<Key> stash;
+    unsigned long count;   // Claves almacenadas, incluidas las del stash
+    double maxLoadFactor;  // 0: sin redimensionado automático
+    unsigned victim;       // Hueco de la siguiente expulsión (rota por la celda)
+    bool saturated;        // Ninguna semilla sirvió con este tamaño (hasta el próximo borrado)
+    std::vector<std::pair<unsigned, unsigned> > path; // Expulsiones (celda, hueco)
+    mutable ProbeStats stats;
+    mutable TableStats counters; // Colisión: la clave nueva no cabe en su primera celda
+
+    unsigned long capacity(unsigned ts) const {
+        return static_cast<unsigned long>(ts) * blockSize;
+    }
+    // Clave guardada que coincide con key, o nullptr. length es el número de
+    // sitios mirados: 1 o 2 celdas, más el stash si no está vacío.
+    template<class K>
+    Key* locate(const K &key, unsigned &length) {
+        return locate(key, fd.hash(key, tableSize), alt.hash(key, tableSize), length);
+    }
+    // Lo mismo con las dos celdas de key ya calculadas.
+    template<class K>
+    Key* locate(const K &key, unsigned first, unsigned second, unsigned &length) {
+        length = 1;
+        if(Key *found = table[first].find(key)) return found;
+        if(second != first) {
+            length++;
+            if(Key *found = table[second].find(key)) return found;
+        }
+        if(stash.empty()) return nullptr;
+        length++;
+        for(Key &elem : stash) {
+            if(keyMatches(elem, key)) return &elem;
+        }
+        return nullptr;
+    }
+    // Coloca key en storage (de ts celdas) expulsando claves si hace falta.
+    // Devuelve las celdas visitadas, o 0 si no cabe en maxKicks expulsiones:
+    // entonces storage queda como estaba.
+    unsigned place(BucketStorage<Key, Container> &storage, unsigned ts, const Key &newKey) {
+        unsigned pos = fd.hash(newKey, ts);
+        if(storage[pos].insert(newKey)) return 1;
+        pos = alt.hash(newKey, ts);
+        if(storage[pos].insert(newKey)) return 2;
+        Key key = newKey;
+        unsigned distance = 0; // Las celdas cuckoo no usan distancias
+        path.clear();
+        for(unsigned kick = 0; kick < maxKicks; kick++) {
+            unsigned slot = victim++ % blockSize;
+            storage[pos].exchange(slot, key, distance);
+            path.push_back(std::make_pair(pos, slot));
+            // La expulsada va a la otra de sus dos celdas.
+            unsigned first = fd.hash(key, ts);
+            pos = first != pos ? first : alt.hash(key, ts);
+            if(storage[pos].insert(key)) return kick + 3;
+        }
+        // Ciclo: cada intercambio deshecho en orden inverso devuelve su clave.
+        for(size_t i = path.size(); i > 0; i--)
+            storage[path[i - 1].first].exchange(path[i - 1].second, key, distance);
+        return 0;
+    }
+    // Tras un borrado, pasa a su celda las claves del stash que ya caben.
+    void drainStash() {
+        for(size_t i = 0; i < stash.size(); ) {
+            const Key &key = stash[i];
+            if(table[fd.hash(key, tableSize)].insert(key) ||
+               table[alt.hash(key, tableSize)].insert(key)) {
+                stash[i] = stash.back();
+                stash.pop_back();
+            } else {
+                i++;
+            }
+        }
+    }
+    // Reconstruye la tabla con newSize celdas y una semilla nueva para alt,
+    // reinsertando todas las claves y extra (si no es nullptr). Prueba hasta
+    // maxReseeds semillas; si con ninguna caben, deja la tabla como estaba.
+    bool rebuild(unsigned newSize, const Key *extra) {
+        unsigned long keys = count + (extra != nullptr ? 1 : 0);
+        if(newSize == 0 || capacity(newSize) + stashSize < keys) return false;
+        unsigned long long oldSeed = alt.getSeed();
+        for(unsigned attempt = 1; attempt <= maxReseeds; attempt++) {
+            alt.setSeed(SplitMix64::at(oldSeed, attempt));
+            BucketStorage<Key, Container> newTable(newSize, blockSize);
+            std::vector<Key> newStash;
+            bool ok = true;
+            auto reinsert = [&](const Key &key) {
+                if(!ok || place(newTable, newSize, key)) return;
+                if(newStash.size() < stashSize) newStash.push_back(key);
+                else ok = false;
+            };
+            const BucketStorage<Key, Container> &current = table; // Sin construir celdas
+            for(unsigned pos = 0; pos < tableSize && ok; pos++)
+                current[pos].forEach(reinsert);
+            for(const Key &key : stash) reinsert(key);
+            if(extra != nullptr) reinsert(*extra);
+            if(!ok) continue;
+            table.swap(newTable);
+            stash.swap(newStash);
+            saturated = false;
+            tableSize = newSize;
+            fd.setTableSize(newSize);
+            alt.setTableSize(newSize);
+            return true;
+        }
+        alt.setSeed(oldSeed);
+        return false;
+    }
+    // Crece hasta que las claves (y extra) caben.
+    void grow(const Key *extra) {
+        unsigned newSize = tableSize;
+        do {
+            newSize = nextPrime(2 * newSize + 1);
+        } while(!rebuild(newSize, extra));
+    }
+    InsertResult insertOrFind(const Key &key, Key *&found) {
+        unsigned length;
+        if((found = locate(key, length)) != nullptr) {
+            stats.record(length);
+            counters.recordInsert(length, false);
+            return PRESENT;
+        }
+        if(maxLoadFactor > 0 && count + 1 > maxLoadFactor * capacity(tableSize))
+            grow(nullptr);
+        unsigned placed = place(table, tableSize, key);
+        stats.record(placed > length ? placed : length);
+        counters.recordInsert(placed > length ? placed : length, placed != 1);
+        if(placed == 0 && stash.size() < stashSize) {
+            stash.push_back(key);
+        } else if(placed == 0 && (saturated || !rebuild(tableSize, &key))) {
+            // Ninguna semilla sirve con este tamaño: no se vuelve a intentar
+            // con cada inserción hasta que se borre alguna clave.
+            saturated = true;
+            if(maxLoadFactor <= 0) return NO_ROOM;
+            grow(&key);
+        }
+        count++;
+        return INSERTED;
+    }
+public:
+    // La semilla inicial de alt es la de MixHashFunction; solo cambia al reconstruir.
+    CuckooHashTable(unsigned ts, Fd& dispFunc, unsigned bs)
+    : tableSize(ts), blockSize(bs), table(ts, bs), fd(dispFunc), alt(ts), count(0),
+      maxLoadFactor(0), victim(0), saturated(false) {}
+    bool search(const Key &key) const override { return find(key) != nullptr; }
+    // Igual que en la dispersión cerrada: K es Key o NumericKey.
+    template<class K>
+    const Key* find(const K &key) const {
+        unsigned length;
+        const Key *found = const_cast<CuckooHashTable*>(this)->locate(key, length);
+        stats.record(length);
+        counters.recordSearch(length, found != nullptr);
+        return found;
+    }
+    // Búsqueda por lotes como en la dispersión cerrada; se piden a caché las dos
+    // celdas de cada clave, así que sus esperas también se solapan entre sí.
+    template<class K>
+    unsigned long search_batch(const std::vector<K> &keys, std::vector<bool> &results) const {
+        CuckooHashTable *self = const_cast<CuckooHashTable*>(this);
+        results.assign(keys.size(), false);
+        unsigned long hits = 0;
+        unsigned firsts[batchWindow], seconds[batchWindow];
+        for(size_t base = 0; base < keys.size(); base += batchWindow) {
+            size_t n = std::min<size_t>(batchWindow, keys.size() - base);
+            for(size_t j = 0; j < n; j++) {
+                firsts[j] = fd.hash(keys[base + j], tableSize);
+                seconds[j] = alt.hash(keys[base + j], tableSize);
+                table.prefetch(firsts[j]);
+                table.prefetch(seconds[j]);
+            }
+            for(size_t j = 0; j < n; j++) {
+                unsigned length;
+                bool found = self->locate(keys[base + j], firsts[j], seconds[j], length) != nullptr;
+                if(found) {
+                    results[base + j] = true;
+                    hits++;
+                }
+                stats.record(length);
+                counters.recordSearch(length, found);
+            }
+        }
+        return hits;
+    }
+    bool insert(const Key &key) override { return insertUnique(key) == INSERTED; }
+    InsertResult insertUnique(const Key &key) {
+        Key *found;
+        return insertOrFind(key, found);
+    }
+    bool insert_or_assign(const Key &key) {
+        Key *found;
+        InsertResult result = insertOrFind(key, found);
+        if(result == PRESENT) *found = key;
+        return result == INSERTED;
+    }
+    template<class... Args>
+    bool emplace(Args&&... args) {
+        return insert(Key(std::forward<Args>(args)...));
+    }
+    bool erase(const Key &key) override {
+        counters.recordErase();
+        unsigned first = fd.hash(key, tableSize);
+        unsigned second = alt.hash(key, tableSize);
+        bool erased = table[first].erase(key) || (second != first && table[second].erase(key));
+        if(erased) {
+            drainStash();
+        } else {
+            for(size_t i = 0; i < stash.size() && !erased; i++) {
+                if(stash[i] == key) {
+                    stash[i] = stash.back();
+                    stash.pop_back();
+                    erased = true;
+                }
+            }
+        }
+        if(erased) {
+            count--;
+            saturated = false;
+        }
+        return erased;
+    }
+    // Reconstruye la tabla con newSize celdas (y una semilla nueva).
+    bool rehash(unsigned newSize) { return rebuild(newSize, nullptr); }
+    void setMaxLoadFactor(double f) { maxLoadFactor = f; }
+    double getMaxLoadFactor() const { return maxLoadFactor; }
+    // Sin lápidas (ver erase).
+    double tombstoneRatio() const { return 0.0; }
+    double loadFactor() const { return static_cast<double>(count) / capacity(tableSize); }
+    unsigned long size() const { return count; }
+    unsigned getTableSize() const { return tableSize; }
+    // Claves en el stash.
+    unsigned stashCount() const { return static_cast<unsigned>(stash.size()); }
+    // Sitios mirados por operación: en las búsquedas nunca más de 3 (ver locate).
+    const ProbeStats& probeStats() const { return stats; }
+    void resetProbeStats() { stats = ProbeStats(); }
+    const TableStats& statistics() const { return counters; }
+    void resetStatistics() { counters = TableStats(); }
+    // Número de celdas con 0, 1, 2, ... claves (sin contar el stash).
+    std::vector<unsigned long> occupancy() const { return occupancyHistogram(table, tableSize); }
+};
+
+// ----------------------------
+// Tablas compartidas entre hilos
+// ----------------------------
+
+// Mutex repartidos en bandas (lock striping): la celda pos de una tabla usa el
+// mutex de la banda pos % size(). Cada banda ocupa dos líneas de caché, de modo
+// que dos mutex nunca comparten línea (un hilo que bloquea una banda no invalida
+// la de otro) aunque el vector de bandas no esté alineado.
+class LockStripes {
+private:
+    static const size_t cacheLine = 64;
+    struct Stripe {
+        std::mutex mtx;
+        char pad[2 * cacheLine > sizeof(std::mutex) ? 2 * cacheLine - sizeof(std::mutex) : 1];
+    };
+    mutable std::vector<Stripe> stripes;
 public:
-    HashTable(unsigned ts, DispersionFunction<Key>& dispFunc)
-    : tableSize(ts), fd(dispFunc) {
-        table.resize(tableSize, nullptr);
-        for(unsigned i = 0; i < tableSize; i++){
-            table[i] = new dynamicSequence<Key>();
+    explicit LockStripes(unsigned n) : stripes(n ? n : 1) {}
+    std::mutex& forBucket(unsigned pos) const { return stripes[pos % stripes.size()].mtx; }
+    unsigned size() const { return static_cast<unsigned>(stripes.size()); }
+    // Bloquea todas las bandas en orden; se liberan al destruir el vector devuelto.
+    // Quien tenga como mucho una banda bloqueada no puede provocar un interbloqueo.
+    std::vector<std::unique_lock<std::mutex> > lockAll() const {
+        std::vector<std::unique_lock<std::mutex> > locks;
+        locks.reserve(stripes.size());
+        for(Stripe &s : stripes)
+            locks.push_back(std::unique_lock<std::mutex>(s.mtx));
+        return locks;
+    }
+};
+
+// Dispersión abierta compartida entre hilos, con bloqueo por bandas (lock striping).
+// Las celdas (Chain: dynamicSequence o inlineSequence) se reparten entre un
+// número fijo de bandas, la celda pos en la banda pos % stripeCount, y cada banda
+// tiene su mutex (LockStripes). Cada operación bloquea solo la banda de la celda
+// de la clave, así que varios hilos pueden insertar, buscar y borrar a la vez
+// mientras sus claves caigan en bandas distintas.
+//
+// Con setMaxLoadFactor(f), f > 0, la inserción que deja la carga por encima de f
+// hace crecer la tabla: bloquea todas las bandas, redistribuye las claves y
+// cambia el tamaño.
+// Una operación calcula la celda con el tamaño que lee sin bloqueo y, tras
+// bloquear la banda, comprueba que no ha cambiado; si ha cambiado lo repite.
+//
+// Las claves no pueden devolverse por puntero, porque otro hilo podría borrarlas
+// o moverlas: find copia la clave encontrada.
+template<class Key, class Chain = dynamicSequence<Key>, class Fd = DispersionFunction<Key> >
+class ConcurrentHashTable : public Sequence<Key> {
+private:
+    typedef std::vector<Chain> Buckets;
+    std::atomic<unsigned> tableSize;
+    Buckets table;
+    Fd& fd;
+    LockStripes stripes;
+    std::atomic<unsigned long> count;
+    double maxLoadFactor;  // 0: sin redimensionado automático
+
+    // Ejecuta op(celda) con la banda de la celda de key bloqueada y devuelve su
+    // resultado. K es Key o NumericKey.
+    template<class K, class Op>
+    auto withBucket(const K &key, Op op) const -> decltype(op(std::declval<Chain&>())) {
+        for(;;) {
+            unsigned ts = tableSize.load(std::memory_order_acquire);
+            unsigned pos = fd.hash(key, ts);
+            std::lock_guard<std::mutex> lock(stripes.forBucket(pos));
+            if(ts == tableSize.load(std::memory_order_relaxed))
+                return op(const_cast<Chain&>(table[pos]));
         }
     }
-    ~HashTable(){
-        for(auto ptr : table)
-            delete ptr;
+    // Crece si la tabla sigue teniendo ts celdas (otro hilo puede haberla hecho
+    // crecer mientras tanto).
+    void grow(unsigned ts) {
+        std::vector<std::unique_lock<std::mutex> > locks = stripes.lockAll();
+        if(ts != tableSize.load(std::memory_order_relaxed)) return;
+        unsigned newSize = nextPrime(2 * ts + 1);
+        Buckets newTable(newSize);
+        for(unsigned pos = 0; pos < ts; pos++) {
+            table[pos].forEach([&](const Key &key) {
+                newTable[fd.hash(key, newSize)].insert(key);
+            });
+        }
+        table.swap(newTable);
+        fd.setTableSize(newSize);
+        tableSize.store(newSize, std::memory_order_release);
     }
+    InsertResult insertOrAssign(const Key &key, bool assign) {
+        InsertResult result = withBucket(key, [&](Chain &chain) -> InsertResult {
+            if(Key *found = chain.find(key)) {
+                if(assign) *found = key;
+                return PRESENT;
+            }
+            return chain.insert(key) ? INSERTED : NO_ROOM;
+        });
+        if(result != INSERTED) return result;
+        unsigned long n = count.fetch_add(1, std::memory_order_relaxed) + 1;
+        unsigned ts = tableSize.load(std::memory_order_relaxed);
+        if(maxLoadFactor > 0 && n > maxLoadFactor * ts)
+            grow(ts);
+        return INSERTED;
+    }
+public:
+    ConcurrentHashTable(unsigned ts, Fd& dispFunc, unsigned stripeCount = 64)
+    : tableSize(ts), table(ts), fd(dispFunc), stripes(stripeCount), count(0),
+      maxLoadFactor(0) {}
     bool search(const Key &key) const override {
-        unsigned pos = fd(key);
-        return table[pos]->search(key);
+        return withBucket(key, [&](Chain &chain) { return chain.find(key) != nullptr; });
     }
-    bool insert(const Key &key) override {
-        unsigned pos = fd(key);
-        return table[pos]->insert(key);
+    // Copia en result la clave que coincide con key (Key o NumericKey).
+    // Devuelve false si no está.
+    template<class K>
+    bool find(const K &key, Key &result) const {
+        return withBucket(key, [&](Chain &chain) -> bool {
+            const Key *found = chain.find(key);
+            if(found != nullptr) result = *found;
+            return found != nullptr;
+        });
+    }
+    bool insert(const Key &key) override { return insertUnique(key) == INSERTED; }
+    InsertResult insertUnique(const Key &key) { return insertOrAssign(key, false); }
+    bool insert_or_assign(const Key &key) { return insertOrAssign(key, true) == INSERTED; }
+    bool erase(const Key &key) override {
+        bool erased = withBucket(key, [&](Chain &chain) { return chain.erase(key); });
+        if(erased) count.fetch_sub(1, std::memory_order_relaxed);
+        return erased;
+    }
+    // No debe llamarse mientras otros hilos usan la tabla.
+    void setMaxLoadFactor(double f) { maxLoadFactor = f; }
+    double getMaxLoadFactor() const { return maxLoadFactor; }
+    double loadFactor() const { return static_cast<double>(size()) / getTableSize(); }
+    unsigned long size() const { return count.load(std::memory_order_relaxed); }
+    unsigned getTableSize() const { return tableSize.load(std::memory_order_relaxed); }
+    unsigned stripeCount() const { return stripes.size(); }
+};
+
+// ----------------------------
+// Reclamación por épocas
+// ----------------------------
+// Un hilo que quita un nodo de una estructura compartida no puede liberarlo en
+// el momento, porque un lector sin bloqueo puede estar leyéndolo. Con la
+// reclamación por épocas cada lector anuncia, mientras dura su operación (Guard),
+// la época global que ha visto; los nodos retirados (retire) se anotan con la
+// época en que se retiraron. La época global solo avanza cuando todos los hilos
+// en una operación han anunciado la actual, así que cuando ha avanzado dos veces
+// desde que se retiró un nodo ningún lector puede tenerlo ya y se libera.
+//
+// Es un único dominio para todo el programa (instance). Cada hilo ocupa una
+// ranura de maxThreads la primera vez que entra y la deja al terminar; si no hay
+// ninguna libre espera a que otro hilo termine.
+class EpochDomain {
+public:
+    static const unsigned maxThreads = 256;
+private:
+    static const size_t cacheLine = 64;
+    static const unsigned long idle = ~0UL; // Ranura fuera de una operación
+    static const unsigned collectEvery = 64; // Retiros entre intentos de liberar
+    struct Slot {
+        std::atomic<unsigned long> epoch;
+        std::atomic<bool> used;
+        char pad[cacheLine];               // Cada ranura en su propia línea
+        Slot() : epoch(idle), used(false) {}
+    };
+    struct Retired {
+        void *ptr;
+        void (*deleter)(void*);
+        unsigned long epoch;
+    };
+    // Ranura del hilo actual y número de Guard anidados.
+    struct ThreadState {
+        Slot *slot;
+        unsigned depth;
+        ThreadState() : slot(nullptr), depth(0) {}
+        ~ThreadState() { if(slot != nullptr) slot->used.store(false, std::memory_order_release); }
+    };
+    std::atomic<unsigned long> globalEpoch;
+    Slot slots[maxThreads];
+    std::mutex retiredMutex;
+    std::vector<Retired> retired;
+    unsigned pending; // Retiros desde el último collect
+
+    EpochDomain() : globalEpoch(0), pending(0) {}
+    ~EpochDomain() {
+        for(const Retired &r : retired) r.deleter(r.ptr);
+    }
+    ThreadState& threadState() {
+        static thread_local ThreadState state;
+        while(state.slot == nullptr) {
+            for(Slot &slot : slots) {
+                bool expected = false;
+                if(slot.used.compare_exchange_strong(expected, true)) {
+                    state.slot = &slot;
+                    break;
+                }
+            }
+            if(state.slot == nullptr) std::this_thread::yield();
+        }
+        return state;
+    }
+    // Avanza la época si todos los hilos en una operación han visto la actual y
+    // libera lo retirado hace dos épocas o más. Con retiredMutex bloqueado.
+    void collect() {
+        unsigned long epoch = globalEpoch.load(std::memory_order_seq_cst);
+        bool advance = true;
+        for(const Slot &slot : slots) {
+            unsigned long seen = slot.epoch.load(std::memory_order_seq_cst);
+            if(seen != idle && seen != epoch) advance = false;
+        }
+        if(advance) globalEpoch.store(++epoch, std::memory_order_seq_cst);
+        size_t kept = 0;
+        for(size_t i = 0; i < retired.size(); i++) {
+            if(retired[i].epoch + 2 <= epoch) retired[i].deleter(retired[i].ptr);
+            else retired[kept++] = retired[i];
+        }
+        retired.resize(kept);
+        pending = 0;
+    }
+public:
+    static EpochDomain& instance() {
+        static EpochDomain domain;
+        return domain;
+    }
+    EpochDomain(const EpochDomain&) = delete;
+    EpochDomain& operator=(const EpochDomain&) = delete;
+    // Operación en curso: mientras exista, nada de lo que el hilo lea de una
+    // estructura protegida se libera. Se pueden anidar.
+    class Guard {
+    private:
+        ThreadState &state;
+    public:
+        Guard() : state(instance().threadState()) {
+            if(state.depth++ == 0)
+                state.slot->epoch.store(instance().globalEpoch.load(std::memory_order_seq_cst),
+                                        std::memory_order_seq_cst);
+        }
+        ~Guard() {
+            if(--state.depth == 0)
+                state.slot->epoch.store(idle, std::memory_order_release);
+        }
+        Guard(const Guard&) = delete;
+        Guard& operator=(const Guard&) = delete;
+    };
+    // Libera ptr con deleter cuando ningún lector pueda tenerlo. ptr ya no debe
+    // ser alcanzable desde la estructura compartida. Se intenta liberar cada
+    // collectEvery retiros o en cada retiro large (p. ej. una tabla entera, que
+    // no debe esperar a que se acumulen otros 63).
+    void retire(void *ptr, void (*deleter)(void*), bool large = false) {
+        std::lock_guard<std::mutex> lock(retiredMutex);
+        Retired r = {ptr, deleter, globalEpoch.load(std::memory_order_seq_cst)};
+        retired.push_back(r);
+        if(large || ++pending >= collectEvery) collect();
+    }
+    // Libera todo lo que ya no pueda estar leyendo ningún hilo. Si no hay
+    // operaciones en curso la época avanza dos veces y se libera todo.
+    void reclaim() {
+        std::lock_guard<std::mutex> lock(retiredMutex);
+        collect();
+        collect();
+    }
+};
+
+// Dispersión abierta con búsquedas sin bloqueo.
+// Cada celda es una lista de nodos inmutables (la clave no cambia una vez
+// publicada) enlazados con punteros atómicos, y lleva un contador de versión
+// (seqlock). Los escritores se serializan por celda con las bandas de LockStripes,
+// igual que en ConcurrentHashTable, y ponen la versión impar mientras modifican
+// la lista. Una búsqueda no bloquea ni escribe en la tabla: lee la versión,
+// recorre la lista y, si la versión ha cambiado (o era impar), la recorre de
+// nuevo; así su resultado corresponde a un estado de la celda que existió.
+// Como la escritura en una celda son un par de asignaciones, un lector casi nunca
+// repite.
+//
+// Los nodos borrados o sustituidos y las tablas antiguas se liberan con
+// EpochDomain: un lector que todavía recorre un nodo quitado sigue leyendo
+// memoria válida y llega al resto de la lista por su puntero siguiente.
+//
+// Con setMaxLoadFactor(f), f > 0, la inserción que supera f bloquea todas las
+// bandas y construye una tabla nueva con copias de los nodos; la antigua no se
+// modifica, así que los lectores que la estén recorriendo terminan sin esperar.
+template<class Key, class Fd = DispersionFunction<Key> >
+class OptimisticHashTable : public Sequence<Key> {
+private:
+    struct Node {
+        Key key;
+        std::atomic<Node*> next;
+        Node(const Key &key, Node *next) : key(key), next(next) {}
+    };
+    struct Bucket {
+        std::atomic<unsigned> version; // Impar: un escritor la está modificando
+        std::atomic<Node*> head;
+        Bucket() : version(0), head(nullptr) {}
+    };
+    struct Buckets {
+        unsigned size;
+        Bucket *cells;
+        explicit Buckets(unsigned ts) : size(ts), cells(new Bucket[ts]) {}
+        ~Buckets() {
+            for(unsigned pos = 0; pos < size; pos++) {
+                Node *node = cells[pos].head.load(std::memory_order_relaxed);
+                while(node != nullptr) {
+                    Node *next = node->next.load(std::memory_order_relaxed);
+                    delete node;
+                    node = next;
+                }
+            }
+            delete[] cells;
+        }
+    };
+    std::atomic<Buckets*> table;
+    Fd& fd;
+    LockStripes stripes;
+    std::atomic<unsigned long> count;
+    double maxLoadFactor;  // 0: sin redimensionado automático
+
+    static void deleteNode(void *p) { delete static_cast<Node*>(p); }
+    static void deleteBuckets(void *p) { delete static_cast<Buckets*>(p); }
+    static void writeBegin(Bucket &b) {
+        b.version.store(b.version.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_release);
+    }
+    static void writeEnd(Bucket &b) {
+        b.version.store(b.version.load(std::memory_order_relaxed) + 1, std::memory_order_release);
+    }
+    // Busca key en su celda sin bloqueo y copia la clave en result si no es nullptr.
+    template<class K>
+    bool lookup(const K &key, Key *result) const {
+        EpochDomain::Guard guard;
+        for(;;) {
+            const Buckets *buckets = table.load(std::memory_order_acquire);
+            const Bucket &b = buckets->cells[fd.hash(key, buckets->size)];
+            unsigned before = b.version.load(std::memory_order_acquire);
+            if(before & 1) continue;
+            const Node *found = nullptr;
+            for(const Node *node = b.head.load(std::memory_order_acquire); node != nullptr;
+                node = node->next.load(std::memory_order_acquire)) {
+                if(keyMatches(node->key, key)) {
+                    found = node;
+                    break;
+                }
+            }
+            std::atomic_thread_fence(std::memory_order_acquire);
+            if(b.version.load(std::memory_order_relaxed) != before) continue;
+            if(found != nullptr && result != nullptr) *result = found->key;
+            return found != nullptr;
+        }
+    }
+    // Ejecuta op(celda) con la banda de la celda de key bloqueada. Comprueba tras
+    // bloquear que la tabla no ha crecido; si ha crecido lo repite.
+    template<class Op>
+    auto withBucket(const Key &key, Op op) -> decltype(op(std::declval<Bucket&>())) {
+        EpochDomain::Guard guard;
+        for(;;) {
+            Buckets *buckets = table.load(std::memory_order_acquire);
+            unsigned pos = fd.hash(key, buckets->size);
+            std::lock_guard<std::mutex> lock(stripes.forBucket(pos));
+            if(buckets == table.load(std::memory_order_relaxed))
+                return op(buckets->cells[pos]);
+        }
+    }
+    // Crece si la tabla sigue siendo buckets. Quien llama debe tener abierto un
+    // Guard desde que leyó buckets: así no se ha liberado ni su dirección puede
+    // ser ya la de otra tabla.
+    void grow(Buckets *buckets) {
+        std::vector<std::unique_lock<std::mutex> > locks = stripes.lockAll();
+        if(buckets != table.load(std::memory_order_relaxed)) return;
+        unsigned newSize = nextPrime(2 * buckets->size + 1);
+        Buckets *newBuckets = new Buckets(newSize);
+        for(unsigned pos = 0; pos < buckets->size; pos++) {
+            for(Node *node = buckets->cells[pos].head.load(std::memory_order_relaxed); node != nullptr;
+                node = node->next.load(std::memory_order_relaxed)) {
+                Bucket &b = newBuckets->cells[fd.hash(node->key, newSize)];
+                b.head.store(new Node(node->key, b.head.load(std::memory_order_relaxed)),
+                             std::memory_order_relaxed);
+            }
+        }
+        fd.setTableSize(newSize);
+        table.store(newBuckets, std::memory_order_release);
+        EpochDomain::instance().retire(buckets, &deleteBuckets, true);
+    }
+    InsertResult insertOrAssign(const Key &key, bool assign) {
+        // El Guard cubre también el uso de seen después de withBucket (ver grow).
+        EpochDomain::Guard guard;
+        Buckets *seen = nullptr;
+        InsertResult result = withBucket(key, [&](Bucket &b) -> InsertResult {
+            std::atomic<Node*> *link = &b.head;
+            for(Node *node = link->load(std::memory_order_relaxed); node != nullptr;
+                link = &node->next, node = link->load(std::memory_order_relaxed)) {
+                if(!(node->key == key)) continue;
+                if(assign) {
+                    // La clave de un nodo publicado no cambia: se sustituye el nodo.
+                    Node *replacement = new Node(key, node->next.load(std::memory_order_relaxed));
+                    writeBegin(b);
+                    link->store(replacement, std::memory_order_release);
+                    writeEnd(b);
+                    EpochDomain::instance().retire(node, &deleteNode);
+                }
+                return PRESENT;
+            }
+            Node *node = new Node(key, b.head.load(std::memory_order_relaxed));
+            writeBegin(b);
+            b.head.store(node, std::memory_order_release);
+            writeEnd(b);
+            seen = table.load(std::memory_order_relaxed);
+            return INSERTED;
+        });
+        if(result != INSERTED) return result;
+        unsigned long n = count.fetch_add(1, std::memory_order_relaxed) + 1;
+        if(maxLoadFactor > 0 && n > maxLoadFactor * seen->size)
+            grow(seen);
+        return INSERTED;
+    }
+public:
+    OptimisticHashTable(unsigned ts, Fd& dispFunc, unsigned stripeCount = 64)
+    : table(new Buckets(ts)), fd(dispFunc), stripes(stripeCount), count(0), maxLoadFactor(0) {}
+    // Sin otros hilos usando la tabla. Lo retirado antes queda en EpochDomain
+    // hasta que ningún hilo pueda leerlo; si no hay operaciones en curso (de
+    // esta u otras tablas) se libera aquí.
+    ~OptimisticHashTable() {
+        delete table.load(std::memory_order_relaxed);
+        EpochDomain::instance().reclaim();
+    }
+    OptimisticHashTable(const OptimisticHashTable&) = delete;
+    OptimisticHashTable& operator=(const OptimisticHashTable&) = delete;
+    bool search(const Key &key) const override { return lookup(key, nullptr); }
+    // Copia en result la clave que coincide con key (Key o NumericKey).
+    // Devuelve false si no está.
+    template<class K>
+    bool find(const K &key, Key &result) const { return lookup(key, &result); }
+    bool insert(const Key &key) override { return insertUnique(key) == INSERTED; }
+    InsertResult insertUnique(const Key &key) { return insertOrAssign(key, false); }
+    bool insert_or_assign(const Key &key) { return insertOrAssign(key, true) == INSERTED; }
+    bool erase(const Key &key) override {
+        bool erased = withBucket(key, [&](Bucket &b) -> bool {
+            std::atomic<Node*> *link = &b.head;
+            for(Node *node = link->load(std::memory_order_relaxed); node != nullptr;
+                link = &node->next, node = link->load(std::memory_order_relaxed)) {
+                if(!(node->key == key)) continue;
+                writeBegin(b);
+                link->store(node->next.load(std::memory_order_relaxed), std::memory_order_release);
+                writeEnd(b);
+                EpochDomain::instance().retire(node, &deleteNode);
+                return true;
+            }
+            return false;
+        });
+        if(erased) count.fetch_sub(1, std::memory_order_relaxed);
+        return erased;
+    }
+    // No debe llamarse mientras otros hilos usan la tabla.
+    void setMaxLoadFactor(double f) { maxLoadFactor = f; }
+    double getMaxLoadFactor() const { return maxLoadFactor; }
+    double loadFactor() const { return static_cast<double>(size()) / getTableSize(); }
+    unsigned long size() const { return count.load(std::memory_order_relaxed); }
+    unsigned getTableSize() const {
+        EpochDomain::Guard guard;
+        return table.load(std::memory_order_acquire)->size;
     }
+    unsigned stripeCount() const { return stripes.size(); }
 };
 
 #endif // HASHTABLE_HPP
@@ -0,0 +1,974 @@
+#include <iostream>
+#include <fstream>
+#include <limits>
+#include <vector>
+#include <string>
+#include <cstring>
+#include <cstdlib>
+#include <cstdio>
+#include <chrono>
+#include <random>
+#include <algorithm>
+#include <thread>
+#include <atomic>
+#include <memory>
+#include "HashFunctions.hpp"
+#include "HashTable.hpp"
+
+using namespace std;
+
+// Banco de pruebas de la tabla hash.
+// Recorre todas las combinaciones de función de dispersión, función de exploración
+// y tipo de dispersión para varios factores de carga y tamaños de bloque, y muestra
+// una fila por combinación en formato CSV (o JSON con -json) con:
+//   hash                       -> open, open-inline (celdas inlineSequence), close, flat,
+//                                 flat-policy (flat con las funciones concretas como parámetros
+//                                 de plantilla, sin llamadas virtuales) o cuckoo
+//                                 (CuckooHashTable con celdas planas)
+//   key                        -> tipo de clave ('persona' o 'compacta', ver personaCompacta)
+//   ns_insert, ns_hit, ns_miss -> nanosegundos por inserción, búsqueda con éxito y fallida
+//   probes_*                   -> media de celdas visitadas por operación (no en 'open');
+//                                 en 'cuckoo' también cuenta el stash
+//   max_probes_miss            -> exploración más larga de una búsqueda fallida
+//   failed                     -> inserciones que no encontraron hueco
+//
+// Con -scaling mide el rendimiento de las tablas compartidas entre hilos (ver
+// runScaling).
+//
+// Con -stress comprueba las tablas compartidas con varios hilos a la vez (ver
+// stressTable).
+//
+// Con -bulk compara el tiempo de construcción con bulk_load (carga masiva en
+// paralelo) y con un bucle de insert (ver runBulk).
+//
+// Con -batch compara las búsquedas e inserciones por lotes (search_batch,
+// insert_batch) con las de una en una (ver runBatch).
+//
+// Con -dist mide la calidad del reparto de las funciones de dispersión (ver
+// runDistribution).
+//
+// Con -growth mide en cambio la latencia de inserción mientras la tabla crece
+// (redimensionado automático), comparando el rehash completo con el incremental:
+//   hash, rehash_step, keys, final_ts, ns_insert, p50, p99, p999, max (ns por inserción)
+
+typedef std::chrono::steady_clock Clock;
+
+// Resultado de medir una configuración.
+struct BenchResult {
+    string keyType;
+    string hashType;
+    string fdName;
+    string feName;
+    unsigned tableSize;
+    unsigned blockSize;
+    double load;
+    unsigned long keys;
+    double nsInsert, nsHit, nsMiss;
+    double probesInsert, probesHit, probesMiss;
+    unsigned maxProbesMiss;
+    bool hasProbes;
+    unsigned long failed;
+};
+
+// Número de ID distintos posibles: 10^7 por cada prefijo alu/prof/pas.
+const unsigned long keySpace = 30000000UL;
+
+// Genera n personas con ID distintos y aleatorios (prefijo alu/prof/pas).
+// Los ID se sacan de una permutación de [0, keySpace) para que no se repitan,
+// así que n no puede pasar de keySpace (lo comprueba main).
+vector<persona> makeKeys(unsigned long n, std::mt19937 &rng) {
+    static const char *prefixes[] = {"alu", "prof", "pas"};
+    std::uniform_int_distribution<unsigned long> dist(0, keySpace - 1);
+    vector<unsigned long> ids;
+    ids.reserve(n);
+    vector<bool> used(keySpace, false);
+    while(ids.size() < n) {
+        unsigned long v = dist(rng);
+        if(used[v]) continue;
+        used[v] = true;
+        ids.push_back(v);
+    }
+    vector<persona> keys;
+    keys.reserve(n);
+    char buf[16];
+    for(unsigned long v : ids) {
+        snprintf(buf, sizeof(buf), "%s%07lu", prefixes[v / 10000000UL], v % 10000000UL);
+        keys.push_back(persona(buf, "Nombre", "Apellido1", "Apellido2"));
+    }
+    return keys;
+}
+
+// Tiempo medio en nanosegundos por elemento de una fase.
+double nsPer(Clock::time_point t0, Clock::time_point t1, unsigned long n) {
+    return n ? std::chrono::duration<double, std::nano>(t1 - t0).count() / n : 0.0;
+}
+
+// Acumulador para que el compilador no elimine las búsquedas.
+volatile unsigned long sink = 0;
+
+// Mide inserciones, aciertos y fallos sobre una tabla de dispersión cerrada.
+template<class Table, class Key>
+void measureClosed(Table &table, const vector<Key> &keys, const vector<Key> &misses,
+                   BenchResult &r) {
+    unsigned long failed = 0, found = 0;
+    Clock::time_point t0 = Clock::now();
+    for(const Key &p : keys)
+        if(!table.insert(p)) failed++;
+    Clock::time_point t1 = Clock::now();
+    r.probesInsert = table.probeStats().average();
+    table.resetProbeStats();
+    for(const Key &p : keys)
+        if(table.search(p)) found++;
+    Clock::time_point t2 = Clock::now();
+    r.probesHit = table.probeStats().average();
+    table.resetProbeStats();
+    for(const Key &p : misses)
+        if(table.search(p)) found++;
+    Clock::time_point t3 = Clock::now();
+    r.probesMiss = table.probeStats().average();
+    r.maxProbesMiss = table.probeStats().maxProbes;
+    sink += found;
+    r.nsInsert = nsPer(t0, t1, keys.size());
+    r.nsHit = nsPer(t1, t2, keys.size());
+    r.nsMiss = nsPer(t2, t3, misses.size());
+    r.hasProbes = true;
+    r.failed = failed;
+}
+
+// Mide inserciones, aciertos y fallos sobre una tabla de dispersión abierta.
+template<class Table, class Key>
+void measureOpen(Table &table, const vector<Key> &keys, const vector<Key> &misses,
+                 BenchResult &r) {
+    unsigned long failed = 0, found = 0;
+    Clock::time_point t0 = Clock::now();
+    for(const Key &p : keys)
+        if(!table.insert(p)) failed++;
+    Clock::time_point t1 = Clock::now();
+    for(const Key &p : keys)
+        if(table.search(p)) found++;
+    Clock::time_point t2 = Clock::now();
+    for(const Key &p : misses)
+        if(table.search(p)) found++;
+    Clock::time_point t3 = Clock::now();
+    sink += found;
+    r.nsInsert = nsPer(t0, t1, keys.size());
+    r.nsHit = nsPer(t1, t2, keys.size());
+    r.nsMiss = nsPer(t2, t3, misses.size());
+    r.probesInsert = r.probesHit = r.probesMiss = 0;
+    r.maxProbesMiss = 0;
+    r.hasProbes = false;
+    r.failed = failed;
+}
+
+// Crea la función de dispersión indicada por su código (el mismo que -fd en hash_program).
+template<class Key>
+DispersionFunction<Key>* makeDispersion(int code, unsigned tableSize) {
+    switch(code) {
+        case 1: return new ModuleHashFunction<Key>(tableSize);
+        case 2: return new SumHashFunction<Key>(tableSize);
+        case 3: return new PseudoRandomHashFunction<Key>(tableSize);
+        case 4: return new MultiplyShiftHashFunction<Key>(tableSize);
+        case 5: return new WyHashFunction<Key>(tableSize);
+        case 6: return new FibonacciHashFunction<Key>(tableSize);
+    }
+    return nullptr;
+}
+
+// Crea la función de exploración indicada por su código (el mismo que -fe en hash_program).
+template<class Key>
+ExplorationFunction<Key>* makeExploration(int code, DispersionFunction<Key> &df) {
+    switch(code) {
+        case 1: return new LinearExploration<Key>();
+        case 2: return new QuadraticExploration<Key>();
+        case 3: return new DoubleHashExploration<Key>(df);
+        case 4: return new RedispersionExploration<Key>();
+        case 5: return new RobinHoodExploration<Key>();
+    }
+    return nullptr;
+}
+
+// Mide la tabla plana con las funciones concretas como parámetros de plantilla,
+// es decir, sin ninguna llamada virtual en inserción y búsqueda.
+template<class Key, class Fd, class Fe>
+void measurePolicy(unsigned tableSize, unsigned bs, const vector<Key> &keys,
+                   const vector<Key> &misses, BenchResult &r) {
+    Fd fd(tableSize);
+    Fe fe = ExplorationMaker<Fe>::make(fd);
+    HashTable<Key, flatSequence<Key>, Fd, Fe> table(tableSize, fd, fe, bs);
+    measureClosed(table, keys, misses, r);
+}
+
+// Despacho de measurePolicy por códigos, igual que hash_program.
+template<class Key, class Fd>
+void measurePolicy(int feCode, unsigned tableSize, unsigned bs, const vector<Key> &keys,
+                   const vector<Key> &misses, BenchResult &r) {
+    switch(feCode) {
+        case 1: measurePolicy<Key, Fd, LinearExploration<Key> >(tableSize, bs, keys, misses, r); break;
+        case 2: measurePolicy<Key, Fd, QuadraticExploration<Key> >(tableSize, bs, keys, misses, r); break;
+        case 3: measurePolicy<Key, Fd, DoubleHashExploration<Key, Fd> >(tableSize, bs, keys, misses, r); break;
+        case 4: measurePolicy<Key, Fd, RedispersionExploration<Key> >(tableSize, bs, keys, misses, r); break;
+        case 5: measurePolicy<Key, Fd, RobinHoodExploration<Key> >(tableSize, bs, keys, misses, r); break;
+    }
+}
+
+template<class Key>
+void measurePolicy(int fdCode, int feCode, unsigned tableSize, unsigned bs, const vector<Key> &keys,
+                   const vector<Key> &misses, BenchResult &r) {
+    switch(fdCode) {
+        case 1: measurePolicy<Key, ModuleHashFunction<Key> >(feCode, tableSize, bs, keys, misses, r); break;
+        case 2: measurePolicy<Key, SumHashFunction<Key> >(feCode, tableSize, bs, keys, misses, r); break;
+        case 3: measurePolicy<Key, PseudoRandomHashFunction<Key> >(feCode, tableSize, bs, keys, misses, r); break;
+        case 4: measurePolicy<Key, MultiplyShiftHashFunction<Key> >(feCode, tableSize, bs, keys, misses, r); break;
+        case 5: measurePolicy<Key, WyHashFunction<Key> >(feCode, tableSize, bs, keys, misses, r); break;
+        case 6: measurePolicy<Key, FibonacciHashFunction<Key> >(feCode, tableSize, bs, keys, misses, r); break;
+    }
+}
+
+const char *fdNames[] = {"", "module", "sum", "pseudorandom", "multiplyshift", "wyhash", "fibonacci"};
+const char *feNames[] = {"", "linear", "quadratic", "doublehash", "redispersion", "robinhood"};
+
+void printCsvHeader() {
+    cout << "key,hash,fd,fe,ts,bs,load,keys,ns_insert,ns_hit,ns_miss,"
+            "probes_insert,probes_hit,probes_miss,max_probes_miss,failed\n";
+}
+
+void printCsv(const BenchResult &r) {
+    cout << r.keyType << ',' << r.hashType << ',' << r.fdName << ',' << r.feName << ','
+         << r.tableSize << ',' << r.blockSize << ',' << r.load << ',' << r.keys << ',' << r.nsInsert << ','
+         << r.nsHit << ',' << r.nsMiss << ',';
+    if(r.hasProbes)
+        cout << r.probesInsert << ',' << r.probesHit << ',' << r.probesMiss << ','
+             << r.maxProbesMiss;
+    else
+        cout << ",,,";
+    cout << ',' << r.failed << '\n';
+}
+
+void printJson(const BenchResult &r, bool first) {
+    cout << (first ? "  " : ",\n  ")
+         << "{\"key\":\"" << r.keyType << "\",\"hash\":\"" << r.hashType
+         << "\",\"fd\":\"" << r.fdName
+         << "\",\"fe\":\"" << r.feName << "\",\"ts\":" << r.tableSize
+         << ",\"bs\":" << r.blockSize << ",\"load\":" << r.load << ",\"keys\":" << r.keys
+         << ",\"ns_insert\":" << r.nsInsert << ",\"ns_hit\":" << r.nsHit
+         << ",\"ns_miss\":" << r.nsMiss;
+    if(r.hasProbes)
+        cout << ",\"probes_insert\":" << r.probesInsert << ",\"probes_hit\":" << r.probesHit
+             << ",\"probes_miss\":" << r.probesMiss
+             << ",\"max_probes_miss\":" << r.maxProbesMiss;
+    cout << ",\"failed\":" << r.failed << "}";
+}
+
+// Configuración del barrido, común a todos los tipos de clave.
+const double closedLoads[] = {0.25, 0.5, 0.75, 0.9, 0.95};
+const unsigned blockSizes[] = {1, 4, 8};
+const double openLoads[] = {0.5, 1.0, 2.0, 4.0};
+
+// Mide todas las combinaciones para las funciones de dispersión [fdFirst, fdLast]
+// con claves de tipo Key. Cada configuración usa un prefijo de 'all'.
+template<class Key>
+void sweep(const char *keyType, const vector<Key> &all, const vector<Key> &misses,
+           unsigned tableSize, int fdFirst, int fdLast, vector<BenchResult> &results) {
+    for(int fdCode = fdFirst; fdCode <= fdLast; fdCode++) {
+        DispersionFunction<Key> *df = makeDispersion<Key>(fdCode, tableSize);
+        for(int feCode = 1; feCode <= 5; feCode++) {
+            ExplorationFunction<Key> *ef = makeExploration<Key>(feCode, *df);
+            for(unsigned bs : blockSizes) {
+                for(double load : closedLoads) {
+                    unsigned long n = static_cast<unsigned long>(load * tableSize * bs);
+                    vector<Key> keys(all.begin(), all.begin() + n);
+                    BenchResult r;
+                    r.keyType = keyType;
+                    r.fdName = fdNames[fdCode];
+                    r.feName = feNames[feCode];
+                    r.tableSize = tableSize;
+                    r.blockSize = bs;
+                    r.load = load;
+                    r.keys = n;
+                    {
+                        HashTable<Key, staticSequence<Key> > table(tableSize, *df, *ef, bs);
+                        r.hashType = "close";
+                        measureClosed(table, keys, misses, r);
+                        results.push_back(r);
+                    }
+                    {
+                        HashTable<Key, flatSequence<Key> > table(tableSize, *df, *ef, bs);
+                        r.hashType = "flat";
+                        measureClosed(table, keys, misses, r);
+                        results.push_back(r);
+                    }
+                    r.hashType = "flat-policy";
+                    measurePolicy(fdCode, feCode, tableSize, bs, keys, misses, r);
+                    results.push_back(r);
+                }
+            }
+            delete ef;
+        }
+        for(unsigned bs : blockSizes) {
+            for(double load : closedLoads) {
+                unsigned long n = static_cast<unsigned long>(load * tableSize * bs);
+                vector<Key> keys(all.begin(), all.begin() + n);
+                BenchResult r;
+                r.keyType = keyType;
+                r.fdName = fdNames[fdCode];
+                r.feName = "";
+                r.tableSize = tableSize;
+                r.blockSize = bs;
+                r.load = load;
+                r.keys = n;
+                CuckooHashTable<Key> table(tableSize, *df, bs);
+                r.hashType = "cuckoo";
+                measureClosed(table, keys, misses, r);
+                results.push_back(r);
+            }
+        }
+        for(double load : openLoads) {
+            unsigned long n = static_cast<unsigned long>(load * tableSize);
+            vector<Key> keys(all.begin(), all.begin() + n);
+            BenchResult r;
+            r.keyType = keyType;
+            r.fdName = fdNames[fdCode];
+            r.feName = "";
+            r.tableSize = tableSize;
+            r.blockSize = 0;
+            r.load = load;
+            r.keys = n;
+            {
+                HashTable<Key, dynamicSequence<Key> > table(tableSize, *df);
+                r.hashType = "open";
+                measureOpen(table, keys, misses, r);
+                results.push_back(r);
+            }
+            {
+                HashTable<Key, inlineSequence<Key> > table(tableSize, *df);
+                r.hashType = "open-inline";
+                measureOpen(table, keys, misses, r);
+                results.push_back(r);
+            }
+        }
+        delete df;
+    }
+}
+
+// ----------------------------
+// Calidad del reparto (-dist)
+// ----------------------------
+
+// Claves alu0000001, alu0000002, ..., aluN: los ID consecutivos que asigna la
+// secretaría, el peor caso para las funciones que no mezclan.
+vector<persona> sequentialKeys(unsigned long n) {
+    vector<persona> keys;
+    keys.reserve(n);
+    char buf[16];
+    for(unsigned long v = 1; v <= n; v++) {
+        snprintf(buf, sizeof(buf), "alu%07lu", v);
+        keys.push_back(persona(buf, "", "", ""));
+    }
+    return keys;
+}
+
+// Lee los ID de un fichero (el primero de cada línea, como -queries en hash_program).
+bool readKeys(const char *fileName, vector<persona> &keys) {
+    std::ifstream in(fileName);
+    if(!in) return false;
+    std::string id;
+    while(in >> id) {
+        in.ignore(std::numeric_limits<std::streamsize>::max(), '\n');
+        keys.push_back(persona(id, "", "", ""));
+    }
+    return true;
+}
+
+// Reparte las claves en tableSize celdas con cada función de dispersión, sin
+// insertarlas en ninguna tabla, y muestra una fila por función y tamaño:
+//   used       -> celdas con alguna clave
+//   max_bucket -> claves en la celda más llena
+//   chi2       -> chi-cuadrado de las ocupaciones frente al reparto uniforme
+//   chi2_ratio -> chi2 / (tableSize - 1): cerca de 1 si el reparto es como el de
+//                 una función aleatoria y mucho mayor si hay agrupamiento (las
+//                 funciones multiplicativas quedan por debajo con ID consecutivos,
+//                 que reparten casi por igual)
+void runDistribution(const vector<persona> &keys, const vector<unsigned> &sizes) {
+    cout << "fd,ts,keys,used,max_bucket,chi2,chi2_ratio\n";
+    for(unsigned ts : sizes) {
+        for(int fdCode = 1; fdCode <= 6; fdCode++) {
+            DispersionFunction<persona> *df = makeDispersion<persona>(fdCode, ts);
+            vector<unsigned long> buckets(ts, 0);
+            for(const persona &p : keys)
+                buckets[df->hash(p, ts)]++;
+            double expected = static_cast<double>(keys.size()) / ts;
+            double chi2 = 0;
+            unsigned long used = 0, maxBucket = 0;
+            for(unsigned long c : buckets) {
+                chi2 += (c - expected) * (c - expected) / expected;
+                if(c > 0) used++;
+                if(c > maxBucket) maxBucket = c;
+            }
+            cout << fdNames[fdCode] << ',' << ts << ',' << keys.size() << ',' << used << ','
+                 << maxBucket << ',' << chi2 << ',' << (ts > 1 ? chi2 / (ts - 1) : 0.0) << '\n';
+            delete df;
+        }
+    }
+}
+
+// ----------------------------
+// Latencia durante el crecimiento (-growth)
+// ----------------------------
+
+// Inserta todas las claves midiendo cada inserción por separado y añade una fila
+// con los percentiles de latencia.
+template<class Table, class Key>
+void measureGrowth(Table &table, const char *hashType, unsigned step, const vector<Key> &keys) {
+    vector<double> ns;
+    ns.reserve(keys.size());
+    Clock::time_point start = Clock::now();
+    for(const Key &p : keys) {
+        Clock::time_point t0 = Clock::now();
+        table.insert(p);
+        ns.push_back(std::chrono::duration<double, std::nano>(Clock::now() - t0).count());
+    }
+    double total = nsPer(start, Clock::now(), keys.size());
+    std::sort(ns.begin(), ns.end());
+    auto pct = [&](double q) {
+        return ns[std::min(ns.size() - 1, static_cast<size_t>(q * ns.size()))];
+    };
+    cout << hashType << ',' << step << ',' << keys.size() << ',' << table.getTableSize() << ','
+         << total << ',' << pct(0.5) << ',' << pct(0.99) << ',' << pct(0.999) << ','
+         << ns.back() << '\n';
+}
+
+void runGrowth(const vector<persona> &keys) {
+    const unsigned steps[] = {0, 1, 8};
+    const unsigned initialSize = 17;
+    cout << "hash,rehash_step,keys,final_ts,ns_insert,p50,p99,p999,max\n";
+    for(unsigned step : steps) {
+        {
+            ModuleHashFunction<persona> fd(initialSize);
+            LinearExploration<persona> fe;
+            HashTable<persona, staticSequence<persona>, ModuleHashFunction<persona>,
+                      LinearExploration<persona> > table(initialSize, fd, fe, 4);
+            table.setMaxLoadFactor(0.75);
+            table.setIncrementalRehash(step);
+            measureGrowth(table, "close", step, keys);
+        }
+        {
+            ModuleHashFunction<persona> fd(initialSize);
+            LinearExploration<persona> fe;
+            HashTable<persona, flatSequence<persona>, ModuleHashFunction<persona>,
+                      LinearExploration<persona> > table(initialSize, fd, fe, 4);
+            table.setMaxLoadFactor(0.75);
+            table.setIncrementalRehash(step);
+            measureGrowth(table, "flat", step, keys);
+        }
+        {
+            ModuleHashFunction<persona> fd(initialSize);
+            HashTable<persona, dynamicSequence<persona>, ModuleHashFunction<persona> > table(initialSize, fd);
+            table.setMaxLoadFactor(2.0);
+            table.setIncrementalRehash(step);
+            measureGrowth(table, "open", step, keys);
+        }
+        {
+            ModuleHashFunction<persona> fd(initialSize);
+            HashTable<persona, inlineSequence<persona>, ModuleHashFunction<persona> > table(initialSize, fd);
+            table.setMaxLoadFactor(2.0);
+            table.setIncrementalRehash(step);
+            measureGrowth(table, "open-inline", step, keys);
+        }
+    }
+}
+
+// ----------------------------
+// Escalado con varios hilos (-scaling)
+// ----------------------------
+
+// Reparte ops operaciones entre threads hilos que usan table a la vez. Cada
+// operación es, con probabilidad readPct %, la búsqueda de una clave al azar de
+// keys (la mitad están insertadas: aciertos y fallos) o, si no, la inserción de
+// la siguiente clave del tramo del hilo en keys[prefilled, keys.size()).
+// Devuelve los segundos transcurridos.
+template<class Table>
+double runMixed(Table &table, const vector<persona> &keys, unsigned long prefilled,
+                unsigned threads, unsigned long ops, unsigned readPct) {
+    unsigned long chunk = (keys.size() - prefilled) / threads;
+    std::atomic<unsigned long> found(0);
+    auto work = [&](unsigned t) {
+        SplitMix64 rng(t + 1);
+        const persona *insertKeys = keys.data() + prefilled + t * chunk;
+        unsigned long inserted = 0, hits = 0;
+        for(unsigned long i = 0; i < ops / threads; i++) {
+            unsigned long long r = rng.next();
+            if(r % 100 < readPct) {
+                if(table.search(keys[(r >> 8) % keys.size()])) hits++;
+            } else {
+                table.insert(insertKeys[inserted++ % chunk]);
+            }
+        }
+        found += hits;
+    };
+    Clock::time_point t0 = Clock::now();
+    vector<std::thread> pool;
+    for(unsigned t = 1; t < threads; t++)
+        pool.push_back(std::thread(work, t));
+    work(0);
+    for(std::thread &th : pool)
+        th.join();
+    double secs = std::chrono::duration<double>(Clock::now() - t0).count();
+    sink += found;
+    return secs;
+}
+
+// Mide una tabla compartida (ConcurrentHashTable u OptimisticHashTable) con cada
+// número de hilos, partiendo cada vez de una tabla nueva con prefilled claves.
+template<class Table>
+void scaleTable(const char *name, unsigned stripes, const vector<persona> &keys,
+                unsigned long prefilled, unsigned long ops, unsigned readPct,
+                const vector<unsigned> &threadCounts) {
+    unsigned ts = nextPrime(static_cast<unsigned>(keys.size()));
+    double base = 0;
+    for(unsigned threads : threadCounts) {
+        PseudoRandomHashFunction<persona> fd(ts);
+        Table table(ts, fd, stripes);
+        for(unsigned long i = 0; i < prefilled; i++)
+            table.insert(keys[i]);
+        double secs = runMixed(table, keys, prefilled, threads, ops, readPct);
+        if(threads == 1) base = secs;
+        cout << name << ',' << stripes << ',' << threads << ',' << readPct << ',' << ops
+             << ',' << secs << ',' << ops / secs / 1e6 << ',' << base / secs << '\n';
+    }
+}
+
+// Rendimiento de las tablas compartidas con 1, 2, 4, ... maxThreads hilos para
+// varias mezclas de búsquedas e inserciones: ConcurrentHashTable con una sola
+// banda (un único mutex para toda la tabla) y con 64, OptimisticHashTable (búsquedas
+// sin bloqueo) y, como referencia, la dispersión abierta sin sincronización, que
+// solo puede usar un hilo. Las tablas tienen tantas celdas como claves y no crecen
+// durante la medida.
+void runScaling(const vector<persona> &keys, unsigned maxThreads) {
+    typedef PseudoRandomHashFunction<persona> Fd;
+    const unsigned readPcts[] = {50, 95, 99};
+    unsigned long prefilled = keys.size() / 2;
+    unsigned long ops = 4 * keys.size();
+    unsigned ts = nextPrime(static_cast<unsigned>(keys.size()));
+    vector<unsigned> threadCounts;
+    for(unsigned t = 1; t < maxThreads; t *= 2)
+        threadCounts.push_back(t);
+    threadCounts.push_back(maxThreads);
+    cout << "table,stripes,threads,read_pct,ops,seconds,mops,speedup\n";
+    for(unsigned readPct : readPcts) {
+        {
+            Fd fd(ts);
+            HashTable<persona, dynamicSequence<persona>, Fd> table(ts, fd);
+            for(unsigned long i = 0; i < prefilled; i++)
+                table.insert(keys[i]);
+            double secs = runMixed(table, keys, prefilled, 1, ops, readPct);
+            cout << "open,0,1," << readPct << ',' << ops << ',' << secs << ','
+                 << ops / secs / 1e6 << ",1\n";
+        }
+        typedef ConcurrentHashTable<persona, dynamicSequence<persona>, Fd> Concurrent;
+        scaleTable<Concurrent>("concurrent", 1, keys, prefilled, ops, readPct, threadCounts);
+        scaleTable<Concurrent>("concurrent", 64, keys, prefilled, ops, readPct, threadCounts);
+        scaleTable<OptimisticHashTable<persona, Fd> >("optimistic", 64, keys, prefilled, ops,
+                                                      readPct, threadCounts);
+    }
+}
+
+// ----------------------------
+// Prueba de estrés con varios hilos (-stress)
+// ----------------------------
+
+// Comprueba una tabla compartida (ConcurrentHashTable u OptimisticHashTable) que
+// empieza con 7 celdas y crece mientras la usan threads hilos:
+//   - un lector busca sin parar unas claves fijas, que siempre deben estar;
+//   - todos los hilos insertan las mismas n claves (solo una inserción de cada
+//     clave debe tener éxito) y buscan cada una justo después de insertarla;
+//     el hilo 1 además la sustituye con insert_or_assign;
+//   - después los hilos borran a la vez las n claves, repartidas entre ellos.
+// Está pensada para compilarse con -fsanitize=thread (make check). Muestra una
+// línea por tabla y devuelve false si alguna comprobación falla.
+template<class Table>
+bool stressTable(const char *name, unsigned stripes, unsigned threads, unsigned long n) {
+    const unsigned long fixed = 500;
+    PseudoRandomHashFunction<persona> fd(7);
+    Table table(7, fd, stripes);
+    table.setMaxLoadFactor(2.0);
+    std::atomic<unsigned long> inserted(0), failures(0);
+    std::atomic<bool> stop(false);
+    auto id = [](const char *prefix, unsigned long i) {
+        char buf[32];
+        snprintf(buf, sizeof(buf), "%s%07lu", prefix, i);
+        return std::string(buf);
+    };
+    for(unsigned long i = 0; i < fixed; i++)
+        table.insert(persona(id("pas", i), "N", "A1", "A2"));
+    std::thread reader([&]() {
+        persona out;
+        while(!stop.load()) {
+            for(unsigned long i = 0; i < fixed; i++) {
+                std::string key = id("pas", i);
+                if(!table.find(persona::idKey(key), out) || out.getId() != key) failures++;
+            }
+        }
+    });
+    runParallel(threads, [&](unsigned t) {
+        persona out;
+        for(unsigned long i = 0; i < n; i++) {
+            std::string key = id("alu", i);
+            if(table.insert(persona(key, "N", "A1", "A2"))) inserted++;
+            if(!table.find(persona::idKey(key), out) || out.getId() != key) failures++;
+            if(t == 1) table.insert_or_assign(persona(key, "M", "A1", "A2"));
+        }
+    });
+    if(inserted != n || table.size() != n + fixed) failures++;
+    runParallel(threads, [&](unsigned t) {
+        for(unsigned long i = t; i < n; i += threads) {
+            persona p(id("alu", i), "", "", "");
+            if(!table.erase(p) || table.search(p)) failures++;
+        }
+    });
+    stop = true;
+    reader.join();
+    if(table.size() != fixed) failures++;
+    cout << name << ',' << stripes << ',' << threads << ',' << n << ',' << table.getTableSize()
+         << ',' << (failures == 0 ? "ok" : "FALLO") << '\n';
+    return failures == 0;
+}
+
+// Prueba de estrés de las tablas compartidas: ConcurrentHashTable con una sola
+// banda, con 64 y con celdas en línea, y OptimisticHashTable.
+bool runStress(unsigned threads, unsigned long n) {
+    typedef PseudoRandomHashFunction<persona> Fd;
+    typedef ConcurrentHashTable<persona, dynamicSequence<persona>, Fd> Concurrent;
+    typedef ConcurrentHashTable<persona, inlineSequence<persona>, Fd> ConcurrentInline;
+    cout << "table,stripes,threads,keys,final_ts,result\n";
+    bool ok = true;
+    ok = stressTable<Concurrent>("concurrent", 1, threads, n) && ok;
+    ok = stressTable<Concurrent>("concurrent", 64, threads, n) && ok;
+    ok = stressTable<ConcurrentInline>("concurrent-inline", 8, threads, n) && ok;
+    // Las búsquedas sin bloqueo del lector se cruzan con los crecimientos y los
+    // nodos que retiran insert_or_assign y erase (EpochDomain).
+    ok = stressTable<OptimisticHashTable<persona, Fd> >("optimistic", 8, threads, n) && ok;
+    return ok;
+}
+
+// ----------------------------
+// Carga masiva (-bulk)
+// ----------------------------
+
+// Construye la tabla con un bucle de insert y con bulk_load para cada número de
+// hilos, partiendo cada vez de una tabla nueva (makeTable) que no crece, y añade
+// una fila por número de hilos. speedup compara bulk_load con el bucle.
+template<class MakeTable>
+void measureBulk(const char *hashType, const vector<persona> &keys,
+                 const vector<unsigned> &threadCounts, MakeTable makeTable) {
+    double insertSecs;
+    {
+        auto table = makeTable();
+        Clock::time_point t0 = Clock::now();
+        for(const persona &p : keys)
+            table->insert(p);
+        insertSecs = std::chrono::duration<double>(Clock::now() - t0).count();
+        sink += table->size();
+    }
+    for(unsigned threads : threadCounts) {
+        auto table = makeTable();
+        Clock::time_point t0 = Clock::now();
+        table->bulk_load(keys.begin(), keys.end(), threads);
+        double secs = std::chrono::duration<double>(Clock::now() - t0).count();
+        sink += table->size();
+        cout << hashType << ',' << threads << ',' << keys.size() << ',' << table->size() << ','
+             << insertSecs << ',' << secs << ',' << insertSecs / secs << '\n';
+    }
+}
+
+// Tiempo de construcción con bulk_load frente a insertar las claves una a una,
+// con 1, 2, 4, ... maxThreads hilos. Las tablas cerradas tienen bloques de 4 y
+// factor de carga ~0.75; las abiertas, ~2 claves por celda.
+void runBulk(const vector<persona> &keys, unsigned maxThreads) {
+    typedef PseudoRandomHashFunction<persona> Fd;
+    typedef LinearExploration<persona> Fe;
+    unsigned closedTs = nextPrime(static_cast<unsigned>(keys.size() / 3 + 1));
+    unsigned openTs = nextPrime(static_cast<unsigned>(keys.size() / 2 + 1));
+    vector<unsigned> threadCounts;
+    for(unsigned t = 1; t < maxThreads; t *= 2)
+        threadCounts.push_back(t);
+    threadCounts.push_back(maxThreads);
+    Fd fd(closedTs);
+    Fe fe;
+    Fd openFd(openTs);
+    cout << "hash,threads,keys,inserted,seconds_insert,seconds_bulk,speedup\n";
+    measureBulk("close", keys, threadCounts, [&]() {
+        return std::unique_ptr<HashTable<persona, staticSequence<persona>, Fd, Fe> >(
+            new HashTable<persona, staticSequence<persona>, Fd, Fe>(closedTs, fd, fe, 4));
+    });
+    measureBulk("flat", keys, threadCounts, [&]() {
+        return std::unique_ptr<HashTable<persona, flatSequence<persona>, Fd, Fe> >(
+            new HashTable<persona, flatSequence<persona>, Fd, Fe>(closedTs, fd, fe, 4));
+    });
+    measureBulk("open", keys, threadCounts, [&]() {
+        return std::unique_ptr<HashTable<persona, dynamicSequence<persona>, Fd> >(
+            new HashTable<persona, dynamicSequence<persona>, Fd>(openTs, openFd));
+    });
+    measureBulk("open-inline", keys, threadCounts, [&]() {
+        return std::unique_ptr<HashTable<persona, inlineSequence<persona>, Fd> >(
+            new HashTable<persona, inlineSequence<persona>, Fd>(openTs, openFd));
+    });
+}
+
+// ----------------------------
+// Operaciones por lotes (-batch)
+// ----------------------------
+
+// Inserta keys en una tabla nueva (makeTable) con un bucle de insert y en otra con
+// insert_batch, y busca lookups en la segunda con un bucle de search y con
+// search_batch. Añade una fila con los nanosegundos por operación de cada forma.
+template<class MakeTable>
+void measureBatch(const char *hashType, const vector<persona> &keys,
+                  const vector<persona> &lookups, MakeTable makeTable) {
+    double nsInsert, nsInsertBatch, nsSearch, nsSearchBatch;
+    {
+        auto table = makeTable();
+        Clock::time_point t0 = Clock::now();
+        for(const persona &p : keys)
+            table->insert(p);
+        nsInsert = nsPer(t0, Clock::now(), keys.size());
+    }
+    auto table = makeTable();
+    Clock::time_point t0 = Clock::now();
+    table->insert_batch(keys);
+    nsInsertBatch = nsPer(t0, Clock::now(), keys.size());
+    unsigned long found = 0;
+    t0 = Clock::now();
+    for(const persona &p : lookups)
+        if(table->search(p)) found++;
+    nsSearch = nsPer(t0, Clock::now(), lookups.size());
+    vector<bool> results;
+    t0 = Clock::now();
+    unsigned long foundBatch = table->search_batch(lookups, results);
+    nsSearchBatch = nsPer(t0, Clock::now(), lookups.size());
+    sink += found + foundBatch;
+    cout << hashType << ',' << keys.size() << ',' << lookups.size() << ',' << foundBatch << ','
+         << nsInsert << ',' << nsInsertBatch << ',' << nsSearch << ',' << nsSearchBatch << '\n';
+}
+
+// Coste de insertar y buscar una a una frente a insert_batch y search_batch
+// (celdas pedidas a caché por adelantado). Se buscan en orden aleatorio las
+// claves insertadas y otras tantas que no están. Las tablas son las de runBulk.
+void runBatch(const vector<persona> &all, std::mt19937 &rng) {
+    typedef PseudoRandomHashFunction<persona> Fd;
+    typedef LinearExploration<persona> Fe;
+    vector<persona> keys(all.begin(), all.begin() + all.size() / 2);
+    vector<persona> lookups(all);
+    std::shuffle(lookups.begin(), lookups.end(), rng);
+    unsigned closedTs = nextPrime(static_cast<unsigned>(keys.size() / 3 + 1));
+    unsigned openTs = nextPrime(static_cast<unsigned>(keys.size() / 2 + 1));
+    Fd fd(closedTs);
+    Fe fe;
+    Fd openFd(openTs);
+    cout << "hash,keys,lookups,found,ns_insert,ns_insert_batch,ns_search,ns_search_batch\n";
+    measureBatch("close", keys, lookups, [&]() {
+        return std::unique_ptr<HashTable<persona, staticSequence<persona>, Fd, Fe> >(
+            new HashTable<persona, staticSequence<persona>, Fd, Fe>(closedTs, fd, fe, 4));
+    });
+    measureBatch("flat", keys, lookups, [&]() {
+        return std::unique_ptr<HashTable<persona, flatSequence<persona>, Fd, Fe> >(
+            new HashTable<persona, flatSequence<persona>, Fd, Fe>(closedTs, fd, fe, 4));
+    });
+    measureBatch("open", keys, lookups, [&]() {
+        return std::unique_ptr<HashTable<persona, dynamicSequence<persona>, Fd> >(
+            new HashTable<persona, dynamicSequence<persona>, Fd>(openTs, openFd));
+    });
+    measureBatch("open-inline", keys, lookups, [&]() {
+        return std::unique_ptr<HashTable<persona, inlineSequence<persona>, Fd> >(
+            new HashTable<persona, inlineSequence<persona>, Fd>(openTs, openFd));
+    });
+}
+
+void printUsage(const char *progName) {
+    cout << "Uso: " << progName << " [-ts <tableSize>] [-misses <n>] [-seed <n>] [-json]\n"
+         << "       " << progName << " -growth [-n <claves>] [-seed <n>]\n"
+         << "       " << progName << " -scaling [-threads <n>] [-n <claves>] [-seed <n>]\n"
+         << "       " << progName << " -stress [-threads <n>] [-n <claves>]\n"
+         << "       " << progName << " -bulk [-threads <n>] [-n <claves>] [-seed <n>]\n"
+         << "       " << progName << " -batch [-n <claves>] [-seed <n>]\n"
+         << "       " << progName << " -dist [-n <claves> | -ids <fichero>] [-ts <tableSize>]\n"
+         << "  -ts <tableSize>  Número de celdas de las tablas medidas (por defecto 1009).\n"
+         << "  -misses <n>      Búsquedas fallidas por configuración (por defecto 1000).\n"
+         << "  -seed <n>        Semilla para generar los ID (por defecto 1).\n"
+         << "  -json            Salida en JSON en lugar de CSV.\n"
+         << "  -growth          Latencia de inserción mientras la tabla crece (CSV).\n"
+         << "  -n <claves>      Claves insertadas con -growth o -bulk, usadas con -scaling o -batch\n"
+         << "                   o repartidas con -dist (por defecto 200000; 20000 con -stress).\n"
+         << "  -scaling         Rendimiento de ConcurrentHashTable y OptimisticHashTable (CSV) con\n"
+         << "                   1, 2, 4, ... hilos y mezclas de 50, 95 y 99 % de búsquedas.\n"
+         << "  -stress          Prueba de estrés de ConcurrentHashTable y OptimisticHashTable con\n"
+         << "                   varios hilos (por defecto 4) y 20000 claves; termina con código 1\n"
+         << "                   si falla alguna comprobación. make check la ejecuta compilada con\n"
+         << "                   -fsanitize=thread.\n"
+         << "  -bulk            Tiempo de construcción con bulk_load frente a un bucle de insert\n"
+         << "                   (CSV) con 1, 2, 4, ... hilos.\n"
+         << "  -batch           Coste por operación de insert_batch y search_batch frente a\n"
+         << "                   insertar y buscar una a una (CSV).\n"
+         << "  -threads <n>     Máximo de hilos con -scaling o -bulk (por defecto, los núcleos\n"
+         << "                   disponibles) o hilos con -stress.\n"
+         << "  -dist            Calidad del reparto de cada función de dispersión (CSV): máxima\n"
+         << "                   ocupación y chi-cuadrado. Por defecto con ID consecutivos en tablas\n"
+         << "                   de ~4 claves por celda de tamaño primo, potencia de dos y potencia\n"
+         << "                   de diez; con -ts solo con ese tamaño.\n"
+         << "  -ids <fichero>   Con -dist, reparte los ID del fichero (uno por línea).\n";
+}
+
+int main(int argc, char* argv[]) {
+    unsigned tableSize = 1009;
+    unsigned long missCount = 1000;
+    unsigned seed = 1;
+    bool json = false;
+    bool growth = false;
+    unsigned long growthKeys = 200000;
+    bool dist = false;
+    bool scaling = false;
+    bool bulk = false;
+    bool stress = false;
+    bool threadsGiven = false;
+    bool nGiven = false;
+    bool batch = false;
+    unsigned maxThreads = std::max(1u, std::thread::hardware_concurrency());
+    bool tsGiven = false;
+    const char *idsFile = nullptr;
+    for(int i = 1; i < argc; i++) {
+        if(strcmp(argv[i], "-ts") == 0 && i + 1 < argc) {
+            tableSize = atoi(argv[++i]);
+            tsGiven = true;
+        } else if(strcmp(argv[i], "-misses") == 0 && i + 1 < argc) {
+            missCount = atol(argv[++i]);
+        } else if(strcmp(argv[i], "-seed") == 0 && i + 1 < argc) {
+            seed = atoi(argv[++i]);
+        } else if(strcmp(argv[i], "-json") == 0) {
+            json = true;
+        } else if(strcmp(argv[i], "-growth") == 0) {
+            growth = true;
+        } else if(strcmp(argv[i], "-scaling") == 0) {
+            scaling = true;
+        } else if(strcmp(argv[i], "-stress") == 0) {
+            stress = true;
+        } else if(strcmp(argv[i], "-bulk") == 0) {
+            bulk = true;
+        } else if(strcmp(argv[i], "-batch") == 0) {
+            batch = true;
+        } else if(strcmp(argv[i], "-threads") == 0 && i + 1 < argc) {
+            maxThreads = std::max(1, atoi(argv[++i]));
+            threadsGiven = true;
+        } else if(strcmp(argv[i], "-dist") == 0) {
+            dist = true;
+        } else if(strcmp(argv[i], "-ids") == 0 && i + 1 < argc) {
+            idsFile = argv[++i];
+        } else if(strcmp(argv[i], "-n") == 0 && i + 1 < argc) {
+            growthKeys = atol(argv[++i]);
+            nGiven = true;
+        } else {
+            printUsage(argv[0]);
+            return strcmp(argv[i], "--help") == 0 ? 0 : 1;
+        }
+    }
+    if(tableSize == 0) {
+        printUsage(argv[0]);
+        return 1;
+    }
+    // makeKeys no puede generar más de keySpace ID distintos y -stress usa
+    // ID alu de 7 cifras.
+    if(growthKeys > (stress ? keySpace / 3 : keySpace)) {
+        cerr << "-n debe ser como mucho " << (stress ? keySpace / 3 : keySpace) << endl;
+        return 1;
+    }
+    // runMixed reparte entre los hilos la mitad de las claves que no están
+    // insertadas al empezar: cada hilo necesita al menos una.
+    if(scaling && growthKeys < 2UL * maxThreads) {
+        cerr << "Con -scaling, -n debe ser al menos el doble de -threads" << endl;
+        return 1;
+    }
+
+    if(growth) {
+        std::mt19937 rng(seed);
+        runGrowth(makeKeys(growthKeys, rng));
+        return 0;
+    }
+
+    if(scaling) {
+        std::mt19937 rng(seed);
+        runScaling(makeKeys(growthKeys, rng), maxThreads);
+        return 0;
+    }
+
+    if(stress)
+        return runStress(threadsGiven ? maxThreads : 4, nGiven ? growthKeys : 20000) ? 0 : 1;
+
+    if(bulk) {
+        std::mt19937 rng(seed);
+        runBulk(makeKeys(growthKeys, rng), maxThreads);
+        return 0;
+    }
+
+    if(batch) {
+        std::mt19937 rng(seed);
+        vector<persona> all = makeKeys(growthKeys, rng);
+        runBatch(all, rng);
+        return 0;
+    }
+
+    if(dist) {
+        vector<persona> keys;
+        if(idsFile == nullptr) {
+            keys = sequentialKeys(growthKeys);
+        } else if(!readKeys(idsFile, keys)) {
+            cerr << "No se pudo abrir el fichero de ID: " << idsFile << endl;
+            return 1;
+        }
+        vector<unsigned> sizes;
+        if(tsGiven) {
+            sizes.push_back(tableSize);
+        } else {
+            unsigned target = std::max(1UL, static_cast<unsigned long>(keys.size() / 4));
+            unsigned pow2 = 1, pow10 = 1;
+            while(pow2 <= target / 2) pow2 *= 2;
+            while(pow10 <= target / 10) pow10 *= 10;
+            sizes.push_back(nextPrime(target));
+            sizes.push_back(pow2);
+            sizes.push_back(pow10);
+        }
+        runDistribution(keys, sizes);
+        return 0;
+    }
+
+    // Un único conjunto de claves: cada configuración usa un prefijo de él.
+    unsigned long maxKeys = static_cast<unsigned long>(tableSize * 8 * 0.95);
+    if(maxKeys < tableSize * 4UL) maxKeys = tableSize * 4UL;
+    if(maxKeys + missCount > keySpace) {
+        cerr << "-ts o -misses demasiado grandes: se necesitan " << maxKeys + missCount
+             << " ID distintos y solo hay " << keySpace << endl;
+        return 1;
+    }
+    std::mt19937 rng(seed);
+    vector<persona> all = makeKeys(maxKeys + missCount, rng);
+    vector<persona> misses(all.end() - missCount, all.end());
+    all.resize(maxKeys);
+
+    vector<BenchResult> results;
+    sweep("persona", all, misses, tableSize, 1, 6, results);
+
+    // Las mismas claves en su forma compacta, solo con la función módulo:
+    // la diferencia con persona es el coste de copiar y comparar la clave.
+    vector<personaCompacta> allCompact(all.begin(), all.end());
+    vector<personaCompacta> missesCompact(misses.begin(), misses.end());
+    sweep("compacta", allCompact, missesCompact, tableSize, 1, 1, results);
+
+    if(json) {
+        cout << "[\n";
+        for(size_t i = 0; i < results.size(); i++)
+            printJson(results[i], i == 0);
+        cout << "\n]\n";
+    } else {
+        printCsvHeader();
+        for(const BenchResult &r : results)
+            printCsv(r);
+    }
+    return 0;
+}
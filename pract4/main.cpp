@@ -1,4 +1,8 @@
 #include <iostream>
+#include <fstream>
+#include <limits>
+#include <vector>
+#include <chrono>
 #include <cstring>
 #include <cstdlib>
 #include "HashFunctions.hpp"  // Incluye la definición de persona y las funciones de dispersión/exploración
@@ -17,32 +21,384 @@ void printUsage(char* progName) {
     cout << "    alu<7 dígitos>, prof<7 dígitos> o pas<7 dígitos>\n";
     cout << "  y además guarda su nombre, primer apellido y segundo apellido.\n\n";
     cout << "Uso:\n";
-    cout << "  " << progName << " -ts <tableSize> -fd <fdCode> -hash <open|close> [-bs <blockSize>] [-fe <feCode>]\n\n";
+    cout << "  " << progName << " -ts <tableSize> -fd <fdCode> -hash <open|inline|close|flat|cuckoo> [-bs <blockSize>] [-fe <feCode>]\n";
+    cout << "      [-load <fichero>] [-queries <fichero>] [-maxload <factor>]\n";
+    cout << "      [-rehashstep <n>] [-erase <fichero>] [-stats]\n\n";
     cout << "Opciones:\n";
     cout << "  -ts <tableSize>     Número de celdas de la tabla hash.\n";
     cout << "  -fd <fdCode>        Código de la función de dispersión:\n";
     cout << "                         1  -> Módulo (h(k) = valor_numerico % tableSize)\n";
     cout << "                         2  -> Suma de dígitos (h(k) = suma(dígitos) % tableSize)\n";
-    cout << "                         3  -> Pseudoaleatoria (h(k) = {srand(valor_numerico); rand()} % tableSize)\n";
-    cout << "  -hash <open|close>  Tipo de dispersión:\n";
+    cout << "                         3  -> Pseudoaleatoria (h(k) = mezcla64(valor_numerico) % tableSize)\n";
+    cout << "                         4  -> Multiplicativa (h(k) = bits altos de a * valor_numerico)\n";
+    cout << "                         5  -> Estilo wyhash (dos productos de 128 bits plegados)\n";
+    cout << "                         6  -> Fibonacci (h(k) = bits altos de valor_numerico * 2^64/phi;\n";
+    cout << "                               sin división con tableSize potencia de dos)\n";
+    cout << "                      Las funciones 4-6 reparten bien ID consecutivos con cualquier\n";
+    cout << "                      tableSize (ver 'hash_bench -dist').\n";
+    cout << "  -hash <tipo>        Tipo de dispersión:\n";
     cout << "                         open  -> Dispersión abierta (usa listas dinámicas).\n";
+    cout << "                         inline-> Dispersión abierta con la primera clave de cada\n";
+    cout << "                                  celda en línea (sin un nodo por clave). Cada celda\n";
+    cout << "                                  ocupa " << sizeof(inlineSequence<persona>)
+         << " bytes aunque esté vacía (open: " << sizeof(dynamicSequence<persona>) << ").\n";
     cout << "                         close -> Dispersión cerrada (usa arrays estáticos).\n";
-    cout << "  -bs <blockSize>     Tamaño máximo de registros por celda (solo para 'close').\n";
-    cout << "  -fe <feCode>        Código de la función de exploración (solo para 'close'):\n";
+    cout << "                         flat  -> Dispersión cerrada con todas las celdas en un\n";
+    cout << "                                  único array contiguo.\n";
+    cout << "                         cuckoo-> Dispersión cuckoo: cada clave está en una de dos\n";
+    cout << "                                  celdas (la de -fd y la de una función de mezcla),\n";
+    cout << "                                  así que una búsqueda mira como mucho dos celdas.\n";
+    cout << "  -bs <blockSize>     Tamaño máximo de registros por celda (solo para 'close', 'flat' y 'cuckoo').\n";
+    cout << "  -fe <feCode>        Código de la función de exploración (solo para 'close' y 'flat'):\n";
     cout << "                         1  -> Exploración lineal (g(k,i) = i)\n";
     cout << "                         2  -> Exploración cuadrática (g(k,i) = i^2)\n";
     cout << "                         3  -> Doble dispersión (g(k,i) = f(k) * i)\n";
-    cout << "                         4  -> Redispersión (g(k,i) = f(i)(k))\n\n";
+    cout << "                         4  -> Redispersión (g(k,i) = f(i)(k))\n";
+    cout << "                         5  -> Lineal Robin Hood (g(k,i) = i; al insertar desplaza a\n";
+    cout << "                               las claves más cercanas a su celda inicial)\n";
+    cout << "  -maxload <factor>   Factor de carga máximo: al superarlo la tabla dobla su número de\n";
+    cout << "                      celdas y reinserta las claves (por defecto no se redimensiona).\n";
+    cout << "  -rehashstep <n>     Con -maxload, traslada las claves a la tabla nueva poco a poco:\n";
+    cout << "                      n celdas en cada inserción o búsqueda (por defecto todas de golpe).\n";
+    cout << "                      No se aplica a 'cuckoo', que siempre reinserta todo de golpe.\n";
+    cout << "  -load <fichero>     Modo por lotes: inserta los registros del fichero, uno por línea:\n";
+    cout << "                         <id> <nombre> <apellido1> <apellido2>\n";
+    cout << "                      Los ID repetidos se cuentan aparte y no se insertan de nuevo;\n";
+    cout << "                      los mal formados (sin exactamente 7 dígitos) se descartan.\n";
+    cout << "  -erase <fichero>    Modo por lotes: elimina los ID del fichero (mismo formato que\n";
+    cout << "                      -queries) tras la carga y antes de las consultas.\n";
+    cout << "  -queries <fichero>  Modo por lotes: busca los ID del fichero (uno por línea, el\n";
+    cout << "                      resto de la línea se ignora).\n";
+    cout << "                      Con -load, -erase y/o -queries no se muestra el menú interactivo y al\n";
+    cout << "                      final se informa del rendimiento de inserción y búsqueda.\n";
+    cout << "  -stats              Al terminar muestra cuántas claves tiene cada celda y, si se ha\n";
+    cout << "                      compilado con 'make STATS=1', los contadores de inserciones,\n";
+    cout << "                      búsquedas, borrados y colisiones y el histograma de celdas\n";
+    cout << "                      visitadas por operación.\n\n";
     cout << "Ejemplos:\n";
     cout << "  Dispersión cerrada con exploración lineal:\n";
     cout << "    " << progName << " -ts 100 -fd 1 -hash close -bs 5 -fe 1\n";
     cout << "  Dispersión abierta usando función de suma de dígitos:\n";
     cout << "    " << progName << " -ts 50 -fd 2 -hash open\n";
+    cout << "  Dispersión cuckoo con celdas de 4 registros y crecimiento automático:\n";
+    cout << "    " << progName << " -ts 1000 -fd 3 -hash cuckoo -bs 4 -maxload 0.9\n";
+    cout << "  Carga masiva y consultas desde fichero:\n";
+    cout << "    " << progName << " -ts 1000003 -fd 1 -hash open -load personas.txt -queries ids.txt\n";
     cout << "  Para ver esta ayuda:\n";
     cout << "    " << progName << " --help\n";
     cout << "========================================\n";
 }
 
+// Lee por teclado el ID de una persona; basta para buscarla o eliminarla.
+std::string readId() {
+    std::string id;
+    cout << "Introduce el ID (formato alu/prof/pas seguido de 7 dígitos): ";
+    cin >> id;
+    return id;
+}
+
+// Lee por teclado los datos de una persona mostrando los mensajes del menú.
+persona readPersona() {
+    std::string id, nombre, ape1, ape2;
+    cout << "Introduce el ID (formato alu/prof/pas seguido de 7 dígitos): ";
+    cin >> id;
+    cout << "Introduce el nombre: ";
+    cin >> nombre;
+    cout << "Introduce el primer apellido: ";
+    cin >> ape1;
+    cout << "Introduce el segundo apellido: ";
+    cin >> ape2;
+    return persona(id, nombre, ape1, ape2);
+}
+
+// Menú interactivo común a la dispersión abierta y cerrada.
+// insertError es el mensaje que se muestra cuando falla una inserción.
+template<class Table>
+void runInteractive(Table &table, const char *insertError) {
+    int option;
+    persona p;
+    do {
+        cout << "\nMenú:\n1. Insertar\n2. Buscar\n3. Eliminar\n0. Salir\nOpción: ";
+        if(!(cin >> option)) break;
+        if(option == 1) {
+            p = readPersona();
+            if(!p.valid()) {
+                cout << "ID no válido." << endl;
+                continue;
+            }
+            InsertResult result = table.insertUnique(p);
+            if(result == INSERTED)
+                cout << "Insertado correctamente." << endl;
+            else if(result == PRESENT)
+                cout << "Ya existe una persona con ese ID." << endl;
+            else
+                cout << insertError << endl;
+        } else if(option == 2) {
+            const persona *found = table.find(persona::idKey(readId()));
+            if(found)
+                cout << "Encontrado: " << found->getId() << " " << found->getNombre() << " "
+                     << found->getApellido1() << " " << found->getApellido2() << endl;
+            else
+                cout << "No encontrado." << endl;
+        } else if(option == 3) {
+            if(table.erase(persona(readId(), "", "", "")))
+                cout << "Eliminado." << endl;
+            else
+                cout << "No encontrado." << endl;
+        }
+    } while(option != 0);
+}
+
+// Muestra el resumen de una fase del modo por lotes: operaciones, tiempo y ritmo.
+void printThroughput(const char *phase, unsigned long ops, double seconds) {
+    cout << phase << ": " << ops << " operaciones en " << seconds << " s";
+    if(seconds > 0)
+        cout << " (" << static_cast<unsigned long>(ops / seconds) << " op/s, "
+             << (seconds * 1e9 / (ops ? ops : 1)) << " ns/op)";
+    cout << endl;
+}
+
+// Modo por lotes: inserta todos los registros de loadFile, elimina los ID de
+// eraseFile y después busca todos los ID de queriesFile, sin mensajes por
+// operación. Cualquiera de los ficheros puede omitirse (cadena vacía).
+// Devuelve false si no se pudo abrir alguno.
+template<class Table>
+bool runBatch(Table &table, const std::string &loadFile, const std::string &eraseFile,
+              const std::string &queriesFile) {
+    typedef std::chrono::steady_clock Clock;
+    if(!loadFile.empty()) {
+        std::ifstream in(loadFile.c_str());
+        if(!in) {
+            cerr << "No se pudo abrir el fichero de carga: " << loadFile << endl;
+            return false;
+        }
+        unsigned long inserted = 0, repeated = 0, failed = 0, invalid = 0;
+        std::string id, nombre, ape1, ape2;
+        Clock::time_point t0 = Clock::now();
+        while(in >> id >> nombre >> ape1 >> ape2) {
+            persona p(id, nombre, ape1, ape2);
+            if(!p.valid()) {
+                invalid++;
+                continue;
+            }
+            InsertResult result = table.insertUnique(p);
+            if(result == INSERTED)
+                inserted++;
+            else if(result == PRESENT)
+                repeated++;
+            else
+                failed++;
+        }
+        double secs = std::chrono::duration<double>(Clock::now() - t0).count();
+        printThroughput("Inserción", inserted + repeated + failed + invalid, secs);
+        cout << "  Insertados: " << inserted << "  Repetidos: " << repeated
+             << "  Fallidos: " << failed << "  ID no válidos: " << invalid << endl;
+        cout << "  Celdas: " << table.getTableSize() << "  Factor de carga: " << table.loadFactor() << endl;
+    }
+    if(!eraseFile.empty()) {
+        std::ifstream in(eraseFile.c_str());
+        if(!in) {
+            cerr << "No se pudo abrir el fichero de borrado: " << eraseFile << endl;
+            return false;
+        }
+        unsigned long erased = 0, missing = 0;
+        std::string id;
+        Clock::time_point t0 = Clock::now();
+        while(in >> id) {
+            in.ignore(std::numeric_limits<std::streamsize>::max(), '\n');
+            if(table.erase(persona(id, "", "", "")))
+                erased++;
+            else
+                missing++;
+        }
+        double secs = std::chrono::duration<double>(Clock::now() - t0).count();
+        printThroughput("Borrado", erased + missing, secs);
+        cout << "  Eliminados: " << erased << "  No encontrados: " << missing << endl;
+        cout << "  Factor de carga: " << table.loadFactor()
+             << "  Lápidas: " << table.tombstoneRatio() << endl;
+    }
+    if(!queriesFile.empty()) {
+        std::ifstream in(queriesFile.c_str());
+        if(!in) {
+            cerr << "No se pudo abrir el fichero de consultas: " << queriesFile << endl;
+            return false;
+        }
+        // Se leen todos los ID y se buscan con search_batch, que solapa las
+        // esperas a memoria de búsquedas independientes.
+        std::vector<NumericKey> ids;
+        std::vector<bool> results;
+        std::string id;
+        Clock::time_point t0 = Clock::now();
+        while(in >> id) {
+            in.ignore(std::numeric_limits<std::streamsize>::max(), '\n');
+            ids.push_back(persona::idKey(id));
+        }
+        unsigned long found = table.search_batch(ids, results);
+        unsigned long missing = ids.size() - found;
+        double secs = std::chrono::duration<double>(Clock::now() - t0).count();
+        printThroughput("Búsqueda", found + missing, secs);
+        cout << "  Encontrados: " << found << "  No encontrados: " << missing << endl;
+    }
+    return true;
+}
+
+// Media de celdas visitadas por operación.
+double perOperation(unsigned long probes, unsigned long ops) {
+    return ops ? static_cast<double>(probes) / ops : 0.0;
+}
+
+// Muestra las estadísticas de uso de la tabla (-stats): los contadores de
+// TableStats, si se ha compilado con HASH_STATS, y el histograma de ocupación
+// de las celdas. De los histogramas solo se muestran las entradas no nulas.
+template<class Table>
+void printStats(const Table &table) {
+    const TableStats &s = table.statistics();
+    cout << "Estadísticas:" << endl;
+    if(TableStats::enabled()) {
+        cout << "  Inserciones: " << s.inserts << "  Colisiones: " << s.collisions
+             << "  Celdas por inserción: " << perOperation(s.insertProbes, s.inserts) << endl;
+        cout << "  Búsquedas: " << s.searches << "  Encontradas: " << s.hits
+             << "  Celdas por búsqueda: " << perOperation(s.searchProbes, s.searches) << endl;
+        cout << "  Borrados: " << s.erases << endl;
+        cout << "  Operaciones por celdas visitadas:" << endl;
+        for(unsigned i = 0; i < TableStats::histogramSize; i++) {
+            if(s.probeHistogram[i] == 0) continue;
+            cout << "    " << i + 1 << (i + 1 == TableStats::histogramSize ? " o más" : "")
+                 << ": " << s.probeHistogram[i] << endl;
+        }
+    } else {
+        cout << "  Contadores desactivados (compila con 'make STATS=1')." << endl;
+    }
+    std::vector<unsigned long> occupancy = table.occupancy();
+    cout << "  Celdas por número de claves:" << endl;
+    for(size_t k = 0; k < occupancy.size(); k++) {
+        if(occupancy[k] != 0)
+            cout << "    " << k << ": " << occupancy[k] << endl;
+    }
+}
+
+// ----------------------------
+// Selección de la tabla
+// ----------------------------
+// Cada combinación de función de dispersión, exploración y tipo de celda es una
+// instanciación distinta de HashTable con las clases concretas como parámetros,
+// de modo que sus bucles no tienen llamadas virtuales. Los códigos -fd/-fe de la
+// línea de comandos se traducen en ejecución mediante tablas de despacho.
+
+typedef ModuleHashFunction<persona> ModuleFd;
+typedef SumHashFunction<persona> SumFd;
+typedef PseudoRandomHashFunction<persona> PseudoRandomFd;
+typedef MultiplyShiftHashFunction<persona> MultiplyShiftFd;
+typedef WyHashFunction<persona> WyHashFd;
+typedef FibonacciHashFunction<persona> FibonacciFd;
+
+// Parámetros de ejecución comunes a todas las tablas.
+struct RunOptions {
+    unsigned tableSize;
+    unsigned blockSize;
+    double maxLoadFactor;
+    unsigned rehashStep;
+    bool batch;
+    bool stats;
+    std::string loadFile;
+    std::string eraseFile;
+    std::string queriesFile;
+};
+
+// Ejecuta el modo por lotes o el menú interactivo sobre la tabla y, con -stats,
+// muestra después las estadísticas. Devuelve el código de salida.
+template<class Table>
+int runTable(Table &table, const RunOptions &opt, const char *insertError) {
+    if(opt.batch) {
+        if(!runBatch(table, opt.loadFile, opt.eraseFile, opt.queriesFile))
+            return 1;
+    } else {
+        runInteractive(table, insertError);
+    }
+    if(opt.stats)
+        printStats(table);
+    return 0;
+}
+
+template<class Fd, class Container>
+int runOpen(const RunOptions &opt) {
+    Fd fd(opt.tableSize);
+    HashTable<persona, Container, Fd> table(opt.tableSize, fd);
+    table.setMaxLoadFactor(opt.maxLoadFactor);
+    table.setIncrementalRehash(opt.rehashStep);
+    return runTable(table, opt, "Error al insertar.");
+}
+
+template<class Fd>
+int runCuckoo(const RunOptions &opt) {
+    Fd fd(opt.tableSize);
+    CuckooHashTable<persona, flatSequence<persona>, Fd> table(opt.tableSize, fd, opt.blockSize);
+    table.setMaxLoadFactor(opt.maxLoadFactor);
+    return runTable(table, opt, "Error al insertar (no cabe ni cambiando la función de dispersión).");
+}
+
+template<class Fd, class Fe, class Container>
+int runClosed(const RunOptions &opt) {
+    Fd fd(opt.tableSize);
+    Fe fe = ExplorationMaker<Fe>::make(fd);
+    HashTable<persona, Container, Fd, Fe> table(opt.tableSize, fd, fe, opt.blockSize);
+    table.setMaxLoadFactor(opt.maxLoadFactor);
+    table.setIncrementalRehash(opt.rehashStep);
+    return runTable(table, opt, "Error al insertar (posible saturación en la celda o tabla).");
+}
+
+typedef int (*Runner)(const RunOptions &opt);
+
+// Tabla de despacho de la dispersión abierta, indexada por fdCode - 1.
+template<class Container>
+struct OpenRunners {
+    static Runner get(int fdCode) {
+        static const Runner runners[6] = {
+            &runOpen<ModuleFd, Container>, &runOpen<SumFd, Container>,
+            &runOpen<PseudoRandomFd, Container>, &runOpen<MultiplyShiftFd, Container>,
+            &runOpen<WyHashFd, Container>, &runOpen<FibonacciFd, Container>
+        };
+        return runners[fdCode - 1];
+    }
+};
+
+// Tabla de despacho de la dispersión cuckoo, indexada por fdCode - 1.
+Runner cuckooRunner(int fdCode) {
+    static const Runner runners[6] = {
+        &runCuckoo<ModuleFd>, &runCuckoo<SumFd>, &runCuckoo<PseudoRandomFd>,
+        &runCuckoo<MultiplyShiftFd>, &runCuckoo<WyHashFd>, &runCuckoo<FibonacciFd>
+    };
+    return runners[fdCode - 1];
+}
+
+// Fila de la tabla de despacho de la dispersión cerrada para la función de
+// dispersión Fd, indexada por feCode - 1.
+template<class Fd, class Container>
+Runner closedRunner(int feCode) {
+    static const Runner runners[5] = {
+        &runClosed<Fd, LinearExploration<persona>, Container>,
+        &runClosed<Fd, QuadraticExploration<persona>, Container>,
+        &runClosed<Fd, DoubleHashExploration<persona, Fd>, Container>,
+        &runClosed<Fd, RedispersionExploration<persona>, Container>,
+        &runClosed<Fd, RobinHoodExploration<persona>, Container>
+    };
+    return runners[feCode - 1];
+}
+
+// Tabla de despacho de la dispersión cerrada, indexada por [fdCode - 1][feCode - 1].
+template<class Container>
+struct ClosedRunners {
+    static Runner get(int fdCode, int feCode) {
+        typedef Runner (*Row)(int feCode);
+        static const Row rows[6] = {
+            &closedRunner<ModuleFd, Container>, &closedRunner<SumFd, Container>,
+            &closedRunner<PseudoRandomFd, Container>, &closedRunner<MultiplyShiftFd, Container>,
+            &closedRunner<WyHashFd, Container>, &closedRunner<FibonacciFd, Container>
+        };
+        return rows[fdCode - 1](feCode);
+    }
+};
+
 int main(int argc, char* argv[]) {
     // Muestra ayuda si se usa '--help'
     if(argc == 2 && (strcmp(argv[1], "--help") == 0)) {
@@ -62,6 +418,12 @@ int main(int argc, char* argv[]) {
     int fdCode = 0;
     int feCode = 0;
     string hashType = "";
+    string loadFile = "";
+    string eraseFile = "";
+    string queriesFile = "";
+    double maxLoadFactor = 0;
+    unsigned rehashStep = 0;
+    bool stats = false;
     
     // Procesa los argumentos de línea de comandos.
     for(int i = 1; i < argc; i++){
@@ -75,6 +437,18 @@ int main(int argc, char* argv[]) {
             blockSize = atoi(argv[++i]);
         } else if(strcmp(argv[i], "-fe") == 0 && i + 1 < argc) {
             feCode = atoi(argv[++i]);
+        } else if(strcmp(argv[i], "-load") == 0 && i + 1 < argc) {
+            loadFile = argv[++i];
+        } else if(strcmp(argv[i], "-erase") == 0 && i + 1 < argc) {
+            eraseFile = argv[++i];
+        } else if(strcmp(argv[i], "-queries") == 0 && i + 1 < argc) {
+            queriesFile = argv[++i];
+        } else if(strcmp(argv[i], "-maxload") == 0 && i + 1 < argc) {
+            maxLoadFactor = atof(argv[++i]);
+        } else if(strcmp(argv[i], "-rehashstep") == 0 && i + 1 < argc) {
+            rehashStep = atoi(argv[++i]);
+        } else if(strcmp(argv[i], "-stats") == 0) {
+            stats = true;
         }
     }
     
@@ -83,137 +457,52 @@ int main(int argc, char* argv[]) {
         return 1;
     }
     
-    srand(time(NULL));
-    
-    // Crea la función de dispersión según el código.
-    DispersionFunction<persona>* df = nullptr;
-    switch(fdCode) {
-        case 1:
-            df = new ModuleHashFunction<persona>(tableSize);
-            break;
-        case 2:
-            df = new SumHashFunction<persona>(tableSize);
-            break;
-        case 3:
-            df = new PseudoRandomHashFunction<persona>(tableSize);
-            break;
-        default:
-            cout << "Código de función de dispersión inválido." << endl;
-            return 1;
+    RunOptions opt;
+    opt.tableSize = tableSize;
+    opt.blockSize = blockSize;
+    opt.maxLoadFactor = maxLoadFactor;
+    opt.rehashStep = rehashStep;
+    opt.batch = !loadFile.empty() || !eraseFile.empty() || !queriesFile.empty();
+    opt.stats = stats;
+    opt.loadFile = loadFile;
+    opt.eraseFile = eraseFile;
+    opt.queriesFile = queriesFile;
+
+    if(fdCode < 1 || fdCode > 6) {
+        cout << "Código de función de dispersión inválido." << endl;
+        return 1;
     }
-    
+
     // Si se usa dispersión abierta.
-    if(hashType == "open") {
-        HashTable<persona, dynamicSequence<persona> > table(tableSize, *df);
-        
-        int option;
-        persona p;
-        do {
-            cout << "\nMenú:\n1. Insertar\n2. Buscar\n0. Salir\nOpción: ";
-            cin >> option;
-            if(option == 1) {
-                // Se solicita introducir los datos de la persona.
-                std::string id, nombre, ape1, ape2;
-                cout << "Introduce el ID (formato alu/prof/pas seguido de 7 dígitos): ";
-                cin >> id;
-                cout << "Introduce el nombre: ";
-                cin >> nombre;
-                cout << "Introduce el primer apellido: ";
-                cin >> ape1;
-                cout << "Introduce el segundo apellido: ";
-                cin >> ape2;
-                p = persona(id, nombre, ape1, ape2);
-                if(table.insert(p))
-                    cout << "Insertado correctamente." << endl;
-                else
-                    cout << "Error al insertar." << endl;
-            } else if(option == 2) {
-                std::string id, nombre, ape1, ape2;
-                cout << "Introduce el ID (formato alu/prof/pas seguido de 7 dígitos): ";
-                cin >> id;
-                cout << "Introduce el nombre: ";
-                cin >> nombre;
-                cout << "Introduce el primer apellido: ";
-                cin >> ape1;
-                cout << "Introduce el segundo apellido: ";
-                cin >> ape2;
-                p = persona(id, nombre, ape1, ape2);
-                if(table.search(p))
-                    cout << "Encontrado." << endl;
-                else
-                    cout << "No encontrado." << endl;
-            }
-        } while(option != 0);
+    if(hashType == "open")
+        return OpenRunners<dynamicSequence<persona> >::get(fdCode)(opt);
+    if(hashType == "inline")
+        return OpenRunners<inlineSequence<persona> >::get(fdCode)(opt);
+
+    // Si se usa dispersión cuckoo.
+    if(hashType == "cuckoo") {
+        if(blockSize == 0) {
+            cout << "Para dispersión cuckoo se debe proporcionar blockSize." << endl;
+            return 1;
+        }
+        return cuckooRunner(fdCode)(opt);
     }
+
     // Si se usa dispersión cerrada.
-    else if(hashType == "close") {
+    if(hashType == "close" || hashType == "flat") {
         if(blockSize == 0 || feCode == 0) {
             cout << "Para dispersión cerrada se deben proporcionar blockSize y código de función de exploración." << endl;
             return 1;
         }
-        ExplorationFunction<persona>* ef = nullptr;
-        switch(feCode) {
-            case 1:
-                ef = new LinearExploration<persona>();
-                break;
-            case 2:
-                ef = new QuadraticExploration<persona>();
-                break;
-            case 3:
-                ef = new DoubleHashExploration<persona>(*df);
-                break;
-            case 4:
-                ef = new RedispersionExploration<persona>();
-                break;
-            default:
-                cout << "Código de función de exploración inválido." << endl;
-                return 1;
+        if(feCode < 1 || feCode > 5) {
+            cout << "Código de función de exploración inválido." << endl;
+            return 1;
         }
-        HashTable<persona, staticSequence<persona> > table(tableSize, *df, *ef, blockSize);
-        
-        int option;
-        persona p;
-        do {
-            cout << "\nMenú:\n1. Insertar\n2. Buscar\n0. Salir\nOpción: ";
-            cin >> option;
-            if(option == 1) {
-                std::string id, nombre, ape1, ape2;
-                cout << "Introduce el ID (formato alu/prof/pas seguido de 7 dígitos): ";
-                cin >> id;
-                cout << "Introduce el nombre: ";
-                cin >> nombre;
-                cout << "Introduce el primer apellido: ";
-                cin >> ape1;
-                cout << "Introduce el segundo apellido: ";
-                cin >> ape2;
-                p = persona(id, nombre, ape1, ape2);
-                if(table.insert(p))
-                    cout << "Insertado correctamente." << endl;
-                else
-                    cout << "Error al insertar (posible saturación en la celda o tabla)." << endl;
-            } else if(option == 2) {
-                std::string id, nombre, ape1, ape2;
-                cout << "Introduce el ID (formato alu/prof/pas seguido de 7 dígitos): ";
-                cin >> id;
-                cout << "Introduce el nombre: ";
-                cin >> nombre;
-                cout << "Introduce el primer apellido: ";
-                cin >> ape1;
-                cout << "Introduce el segundo apellido: ";
-                cin >> ape2;
-                p = persona(id, nombre, ape1, ape2);
-                if(table.search(p))
-                    cout << "Encontrado." << endl;
-                else
-                    cout << "No encontrado." << endl;
-            }
-        } while(option != 0);
-        delete ef;
-    } else {
-        cout << "Tipo de hash inválido. Usa 'open' o 'close'." << endl;
-        return 1;
+        if(hashType == "close")
+            return ClosedRunners<staticSequence<persona> >::get(fdCode, feCode)(opt);
+        return ClosedRunners<flatSequence<persona> >::get(fdCode, feCode)(opt);
     }
-    
-    delete df;
-    return 0;
+
+    cout << "Tipo de hash inválido. Usa 'open', 'inline', 'close', 'flat' o 'cuckoo'." << endl;
+    return 1;
 }